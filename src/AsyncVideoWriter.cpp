@@ -0,0 +1,174 @@
+/*
+ * AsyncVideoWriter.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AsyncVideoWriter.h"
+
+#include <iostream>
+
+/**
+ * Convert the value of the recording-overflow-policy setting. Unknown names block,
+ * which never loses a frame.
+ * */
+overflowPolicy parseOverflowPolicy(const std::string& name) {
+	if(name == "drop-oldest") {
+		return OVERFLOW_DROP_OLDEST;
+	} else if(name == "drop-newest") {
+		return OVERFLOW_DROP_NEWEST;
+	}
+	return OVERFLOW_BLOCK;
+}
+
+AsyncVideoWriter::AsyncVideoWriter() {
+	policy = OVERFLOW_BLOCK;
+	running = false;
+	dropped = 0;
+	written = 0;
+}
+
+AsyncVideoWriter::~AsyncVideoWriter() {
+	close();
+}
+
+/**
+ * Open the video file and start the encoder thread with room for queueSize frames.
+ * Returns false if the video file could not be opened.
+ * */
+bool AsyncVideoWriter::open(std::string path, int fourcc, double fps, cv::Size size, int queueSize, overflowPolicy policy) {
+	close();
+	if(!writer.open(path, fourcc, fps, size)) {
+		std::cout << "Error: could not open video writer for " << path << std::endl;
+		return false;
+	}
+	queueSize = std::max(queueSize, 1);
+	this->policy = policy;
+	//one frame more than the queue holds so a new frame can be copied while the encoder works on another
+	frames.assign(queueSize + 1, cv::Mat());
+	freeFrames.clear();
+	for(int i = queueSize; i >= 0; i--) {
+		freeFrames.push_back(i);
+	}
+	queue.set_capacity(queueSize);
+	queue.clear();
+	dropped = 0;
+	written = 0;
+	running = true;
+	encoder = boost::thread(&AsyncVideoWriter::encodeLoop, this);
+	return true;
+}
+
+bool AsyncVideoWriter::isOpened() {
+	return encoder.joinable();
+}
+
+/**
+ * Queue a copy of image for encoding
+ * */
+void AsyncVideoWriter::write(const cv::Mat& image) {
+	if(!isOpened()) {
+		return;
+	}
+	int slot;
+	{
+		boost::unique_lock<boost::mutex> lock(mutex);
+		while(queue.full()) {
+			if(policy == OVERFLOW_BLOCK) {
+				frameFreed.wait(lock);
+			} else if(policy == OVERFLOW_DROP_NEWEST) {
+				dropped++;
+				return;
+			} else {
+				freeFrames.push_back(queue.front());
+				queue.pop_front();
+				dropped++;
+			}
+		}
+		slot = freeFrames.back();
+		freeFrames.pop_back();
+	}
+	//the slot belongs to this thread until it is queued, so copy without holding the lock
+	image.copyTo(frames[slot]);
+	{
+		boost::lock_guard<boost::mutex> lock(mutex);
+		queue.push_back(slot);
+	}
+	frameQueued.notify_one();
+}
+
+/**
+ * Body of the encoder thread. Keeps encoding until closed and the queue is empty.
+ * */
+void AsyncVideoWriter::encodeLoop() {
+	for(;;) {
+		int slot;
+		{
+			boost::unique_lock<boost::mutex> lock(mutex);
+			while(queue.empty() && running) {
+				frameQueued.wait(lock);
+			}
+			if(queue.empty()) {
+				break;
+			}
+			slot = queue.front();
+			queue.pop_front();
+		}
+		if(frames[slot].channels() == 1) {
+			cv::cvtColor(frames[slot], colorFrame, CV_GRAY2RGB);
+			writer << colorFrame;
+		} else {
+			writer << frames[slot];
+		}
+		{
+			boost::lock_guard<boost::mutex> lock(mutex);
+			freeFrames.push_back(slot);
+			written++;
+		}
+		frameFreed.notify_one();
+	}
+}
+
+/**
+ * Encode whatever is still queued, stop the encoder thread and close the video file
+ * */
+void AsyncVideoWriter::close() {
+	if(!encoder.joinable()) {
+		return;
+	}
+	{
+		boost::lock_guard<boost::mutex> lock(mutex);
+		running = false;
+	}
+	frameQueued.notify_one();
+	encoder.join();
+	writer.release();
+}
+
+/**
+ * Number of frames discarded because the encoder could not keep up
+ * */
+unsigned long AsyncVideoWriter::getDroppedFrames() {
+	boost::lock_guard<boost::mutex> lock(mutex);
+	return dropped;
+}
+
+unsigned long AsyncVideoWriter::getWrittenFrames() {
+	boost::lock_guard<boost::mutex> lock(mutex);
+	return written;
+}
@@ -0,0 +1,81 @@
+/*
+ * AsyncVideoWriter.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASYNCVIDEOWRITER_H_
+#define ASYNCVIDEOWRITER_H_
+
+#include "cv.h"
+#include "highgui.h"
+#include <string>
+#include <vector>
+
+#include <boost/thread.hpp>
+#include <boost/circular_buffer.hpp>
+
+typedef enum _overflowPolicy {
+	OVERFLOW_BLOCK, //wait for the encoder to free a slot
+	OVERFLOW_DROP_OLDEST, //replace the oldest queued frame with the new one
+	OVERFLOW_DROP_NEWEST //discard the new frame
+} overflowPolicy;
+
+overflowPolicy parseOverflowPolicy(const std::string& name);
+
+/**
+ * A VideoWriter that encodes on its own thread. Frames are copied into a fixed pool of
+ * buffers and queued, so write() only costs a copy on the calling thread. When the
+ * encoder falls behind and the queue is full the overflow policy decides what happens.
+ * Grayscale frames written to a color video are converted on the encoder thread.
+ */
+class AsyncVideoWriter {
+
+public:
+	AsyncVideoWriter();
+	~AsyncVideoWriter();
+	bool open(std::string path, int fourcc, double fps, cv::Size size, int queueSize, overflowPolicy policy);
+	bool isOpened();
+	void write(const cv::Mat& image);
+	void close();
+	unsigned long getDroppedFrames();
+	unsigned long getWrittenFrames();
+
+private:
+	void encodeLoop();
+
+	cv::VideoWriter writer; //only used by the encoder thread while open
+	std::vector<cv::Mat> frames; //pooled frame buffers, one more than the queue holds
+	std::vector<int> freeFrames; //indexes of frames not queued nor being encoded
+	boost::circular_buffer<int> queue; //indexes of frames waiting to be encoded, oldest first
+	overflowPolicy policy;
+	bool running;
+	unsigned long dropped;
+	unsigned long written;
+	cv::Mat colorFrame; //conversion buffer of the encoder thread
+
+	boost::thread encoder;
+	boost::mutex mutex; //guards freeFrames, queue, running and the counters
+	boost::condition_variable frameQueued;
+	boost::condition_variable frameFreed;
+
+	AsyncVideoWriter(const AsyncVideoWriter&); //Prevent copy-construction
+	AsyncVideoWriter& operator=(const AsyncVideoWriter&); //Prevent assignment
+};
+
+#endif /* ASYNCVIDEOWRITER_H_ */
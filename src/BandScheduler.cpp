@@ -0,0 +1,135 @@
+/*
+ * BandScheduler.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BandScheduler.h"
+#include "ImageUtils.h"
+
+#include <algorithm>
+
+using namespace cv;
+
+//bands smaller than this cost more in halo and scheduling than they save
+static const int min_band_rows = 16;
+
+namespace {
+
+/**
+ * threshold followed by medianBlur of one band, as a single binaryMajorityFilter pass
+ */
+class ThresholdMedianTask : public WorkerTask {
+
+public:
+	ThresholdMedianTask(const std::vector<Band>& bands, std::vector<std::vector<ushort> >& counts, const Mat& source,
+			Mat& binary, double thresh, double maxValue, int medianSize) :
+		bands(bands), counts(counts), source(source), binary(binary) {
+		this->thresh = thresh;
+		this->maxValue = maxValue;
+		this->medianSize = medianSize;
+	}
+
+	void run(int index, int worker) {
+		binaryMajorityFilter(source, binary, bands[index].rows, thresh, maxValue, medianSize, counts[index]);
+	}
+
+private:
+	const std::vector<Band>& bands;
+	std::vector<std::vector<ushort> >& counts;
+	const Mat& source;
+	Mat& binary;
+	double thresh;
+	double maxValue;
+	int medianSize;
+};
+
+class GrayToColorTask : public WorkerTask {
+
+public:
+	GrayToColorTask(const std::vector<Band>& bands, const Mat& gray, Mat& color) :
+		bands(bands), gray(gray), color(color) {
+	}
+
+	void run(int index, int worker) {
+		Mat colorBand = color.rowRange(bands[index].rows);
+		cvtColor(gray.rowRange(bands[index].rows), colorBand, CV_GRAY2BGR);
+	}
+
+private:
+	const std::vector<Band>& bands;
+	const Mat& gray;
+	Mat& color;
+};
+
+}
+
+BandScheduler::BandScheduler() {
+	pool = NULL;
+}
+
+void BandScheduler::setWorkerPool(WorkerPool* pool) {
+	this->pool = pool;
+}
+
+WorkerPool* BandScheduler::getWorkerPool() {
+	return pool;
+}
+
+/**
+ * Split rows into one band per thread of the pool, but no band smaller than minRows.
+ * Returns the number of bands.
+ */
+int BandScheduler::split(int rows, int halo, int minRows, std::vector<Band>& bands) {
+	int threads = pool != NULL ? pool->getThreadCount() : 1;
+	int count = std::max(1, std::min(threads, rows / std::max(1, minRows)));
+	bands.resize(count);
+	for(int i = 0; i < count; i++) {
+		bands[i].rows = Range(rows * i / count, rows * (i + 1) / count);
+		bands[i].input = Range(std::max(0, bands[i].rows.start - halo), std::min(rows, bands[i].rows.end + halo));
+	}
+	return count;
+}
+
+/**
+ * Binary image of the hands: threshold source and clean it up with a median filter.
+ * Same result as threshold() and medianBlur() but in constant time per pixel.
+ */
+void BandScheduler::thresholdMedian(const Mat& source, Mat& binary, double thresh, double maxValue, int medianSize) {
+	binary.create(source.size(), CV_8UC1);
+	counts.resize(split(source.rows, medianSize / 2, min_band_rows, bands));
+	ThresholdMedianTask task(bands, counts, source, binary, thresh, maxValue, medianSize);
+	runBands(task);
+}
+
+void BandScheduler::grayToColor(const Mat& gray, Mat& color) {
+	color.create(gray.size(), CV_8UC3);
+	split(gray.rows, 0, min_band_rows, bands);
+	GrayToColorTask task(bands, gray, color);
+	runBands(task);
+}
+
+void BandScheduler::runBands(WorkerTask& task) {
+	if(pool != NULL) {
+		pool->run(task, bands.size());
+	} else {
+		for(unsigned int i = 0; i < bands.size(); i++) {
+			task.run(i, 0);
+		}
+	}
+}
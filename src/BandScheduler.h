@@ -0,0 +1,60 @@
+/*
+ * BandScheduler.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BANDSCHEDULER_H_
+#define BANDSCHEDULER_H_
+
+#include "cv.h"
+#include "WorkerPool.h"
+#include <vector>
+
+/**
+ * Rows of an image processed by one task
+ */
+struct Band {
+	cv::Range rows; //rows written by the band
+	cv::Range input; //rows read by the band: rows plus the halo of the kernel, clipped to the image
+};
+
+/**
+ * Runs the per pixel image stages of a frame on a WorkerPool by splitting the frame
+ * into horizontal bands. Each band reads the halo its kernel needs around its rows,
+ * so the result is identical to processing the whole frame at once.
+ */
+class BandScheduler {
+
+public:
+	BandScheduler();
+	void setWorkerPool(WorkerPool* pool);
+	WorkerPool* getWorkerPool();
+	int split(int rows, int halo, int minRows, std::vector<Band>& bands);
+	void thresholdMedian(const cv::Mat& source, cv::Mat& binary, double thresh, double maxValue, int medianSize);
+	void grayToColor(const cv::Mat& gray, cv::Mat& color);
+
+private:
+	void runBands(WorkerTask& task);
+
+	WorkerPool* pool; //NULL to run every band on the calling thread
+	std::vector<Band> bands;
+	std::vector<std::vector<ushort> > counts; //column counts of the majority filter of each band
+};
+
+#endif /* BANDSCHEDULER_H_ */
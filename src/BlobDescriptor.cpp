@@ -0,0 +1,84 @@
+/*
+ * BlobDescriptor.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BlobDescriptor.h"
+
+#include <cmath>
+
+using namespace cv;
+
+static float distance(const Point2f a, const Point2f b) {
+	return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+}
+
+/**
+ * Fill blob with every measure of contour the hands need
+ */
+void describeBlob(const std::vector<Point>& contour, int index, BlobDescriptor& blob) {
+	Mat points(contour);
+	blob.contour = index;
+	blob.contourSize = contour.size();
+	blob.bounds = boundingRect(points);
+	blob.minRect = minAreaRect(points);
+	minEnclosingCircle(points, blob.circleCenter, blob.circleRadius);
+	blob.moments = moments(points, false);
+	blob.massCenter = Point2f(blob.moments.m10 / blob.moments.m00, blob.moments.m01 / blob.moments.m00);
+}
+
+/**
+ * Decide which hand each of the blobCount (at most two) largest blobs belongs to,
+ * given where the hands were in the previous frame. A single blob stays with the
+ * hand that was closer to it, two blobs are matched to keep their sides.
+ */
+HandAssignment assignHands(int blobCount, Point2f max1Center, Point2f max2Center,
+		bool handOnePresent, Point2f handOneCenter, bool handTwoPresent, Point2f handTwoCenter,
+		float radiusThreshold) {
+	HandAssignment assignment;
+	assignment.handOne = -1;
+	assignment.handTwo = -1;
+	bool max1IsHandOne;
+	if(blobCount >= 2) {
+		if(!handOnePresent && !handTwoPresent) {
+			//default: max1 is hand one
+			max1IsHandOne = true;
+		} else if(handOnePresent && !handTwoPresent) {
+			max1IsHandOne = distance(handOneCenter, max1Center) < distance(handOneCenter, max2Center);
+		} else {
+			max1IsHandOne = distance(handTwoCenter, max1Center) > distance(handTwoCenter, max2Center);
+		}
+		assignment.handOne = max1IsHandOne ? 0 : 1;
+		assignment.handTwo = max1IsHandOne ? 1 : 0;
+	} else if(blobCount == 1) {
+		if(!handOnePresent && !handTwoPresent) {
+			max1IsHandOne = true;
+		} else if(handOnePresent && !handTwoPresent) {
+			max1IsHandOne = distance(handOneCenter, max1Center) < radiusThreshold * 4;
+		} else {
+			max1IsHandOne = distance(handTwoCenter, max1Center) > radiusThreshold * 4;
+		}
+		if(max1IsHandOne) {
+			assignment.handOne = 0;
+		} else {
+			assignment.handTwo = 0;
+		}
+	}
+	return assignment;
+}
@@ -0,0 +1,55 @@
+/*
+ * BlobDescriptor.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLOBDESCRIPTOR_H_
+#define BLOBDESCRIPTOR_H_
+
+#include "cv.h"
+#include <vector>
+
+/**
+ * Shape of one hand candidate, computed once from its contour
+ */
+struct BlobDescriptor {
+	int contour; //index of the contour in the contour list of the frame
+	int contourSize; //number of points of the contour
+	cv::Rect bounds; //bounding rectangle of the contour
+	cv::RotatedRect minRect; //enclosing rectangle with minimum area
+	cv::Point2f circleCenter; //center of minimum enclosing circle
+	float circleRadius; //radius of minimum enclosing circle
+	cv::Moments moments;
+	cv::Point2f massCenter;
+};
+
+/**
+ * Which of the two largest blobs of a frame becomes which hand
+ */
+struct HandAssignment {
+	int handOne; //0 for the largest blob, 1 for the second largest, -1 if hand one is absent
+	int handTwo; //same for hand two
+};
+
+void describeBlob(const std::vector<cv::Point>& contour, int index, BlobDescriptor& blob);
+HandAssignment assignHands(int blobCount, cv::Point2f max1Center, cv::Point2f max2Center,
+		bool handOnePresent, cv::Point2f handOneCenter, bool handTwoPresent, cv::Point2f handTwoCenter,
+		float radiusThreshold);
+
+#endif /* BLOBDESCRIPTOR_H_ */
@@ -0,0 +1,292 @@
+/*
+ * BlobExtractor.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BlobExtractor.h"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace cv;
+
+BlobExtractor::BlobExtractor() {
+}
+
+int BlobExtractor::root(int run) {
+	while(runs[run].parent != run) {
+		//path halving keeps the trees flat
+		runs[run].parent = runs[runs[run].parent].parent;
+		run = runs[run].parent;
+	}
+	return run;
+}
+
+/**
+ * Join the blobs of two runs. The root is always the earliest run of a blob, so
+ * blobs come out in the raster order of their first pixel like findContours()
+ */
+void BlobExtractor::merge(int a, int b) {
+	a = root(a);
+	b = root(b);
+	if(a < b) {
+		runs[b].parent = a;
+	} else if(b < a) {
+		runs[a].parent = b;
+	}
+}
+
+/**
+ * Label the blobs of binary (any non zero pixel is set) and compute their statistics
+ */
+void BlobExtractor::extract(const Mat& binary) {
+	CV_Assert(binary.type() == CV_8UC1);
+	runs.clear();
+	int previousBegin = 0, previousEnd = 0; //runs of the row above
+	for(int y = 0; y < binary.rows; y++) {
+		const uchar* p = binary.ptr(y);
+		int rowBegin = runs.size();
+		int x = 0;
+		while(x < binary.cols) {
+			while(x < binary.cols && p[x] == 0) {
+				x++;
+			}
+			if(x == binary.cols) {
+				break;
+			}
+			Run run;
+			run.y = y;
+			run.start = x;
+			while(x < binary.cols && p[x] != 0) {
+				x++;
+			}
+			run.end = x - 1;
+			run.parent = runs.size();
+			runs.push_back(run);
+		}
+		//runs of the row above touching a run, including diagonally, belong to its blob
+		int j = previousBegin;
+		for(int i = rowBegin; i < (int)runs.size(); i++) {
+			while(j < previousEnd && runs[j].end < runs[i].start - 1) {
+				j++;
+			}
+			for(int k = j; k < previousEnd && runs[k].start <= runs[i].end + 1; k++) {
+				merge(i, k);
+			}
+		}
+		previousBegin = rowBegin;
+		previousEnd = runs.size();
+	}
+
+	//statistics of each blob from its runs
+	blobs.clear();
+	blobOfRun.resize(runs.size());
+	for(unsigned int i = 0; i < runs.size(); i++) {
+		const Run& run = runs[i];
+		int r = root(i);
+		if(r == (int)i) {
+			BlobStats stats;
+			stats.area = 0;
+			stats.bounds = Rect(run.start, run.y, 0, 0);
+			stats.m10 = 0;
+			stats.m01 = 0;
+			blobOfRun[i] = blobs.size();
+			blobs.push_back(stats);
+		} else {
+			blobOfRun[i] = blobOfRun[r];
+		}
+		BlobStats& stats = blobs[blobOfRun[i]];
+		int length = run.end - run.start + 1;
+		stats.area += length;
+		stats.m10 += 0.5 * (run.start + run.end) * length;
+		stats.m01 += (double)run.y * length;
+		//a blob starts at its root run, so only the left, right and bottom edges move
+		int left = std::min(stats.bounds.x, run.start);
+		int right = std::max(stats.bounds.x + stats.bounds.width, run.end + 1);
+		stats.bounds = Rect(left, stats.bounds.y, right - left, run.y + 1 - stats.bounds.y);
+	}
+	for(unsigned int b = 0; b < blobs.size(); b++) {
+		blobs[b].centroid = Point2f(blobs[b].m10 / blobs[b].area, blobs[b].m01 / blobs[b].area);
+	}
+
+	//group the runs by blob so a blob can be drawn without scanning all the runs
+	firstRun.assign(blobs.size() + 1, 0);
+	for(unsigned int i = 0; i < runs.size(); i++) {
+		firstRun[blobOfRun[i] + 1]++;
+	}
+	for(unsigned int b = 0; b < blobs.size(); b++) {
+		firstRun[b + 1] += firstRun[b];
+	}
+	blobRuns.resize(runs.size());
+	std::vector<int> next(firstRun.begin(), firstRun.end() - 1);
+	for(unsigned int i = 0; i < runs.size(); i++) {
+		blobRuns[next[blobOfRun[i]]++] = i;
+	}
+}
+
+const std::vector<BlobStats>& BlobExtractor::getBlobs() {
+	return blobs;
+}
+
+/**
+ * Outer contour of one blob, in image coordinates, the same as findContours() with
+ * RETR_EXTERNAL and CHAIN_APPROX_NONE finds for it in the whole image
+ */
+void BlobExtractor::traceContour(int blob, std::vector<Point>& contour) {
+	const Rect& bounds = blobs[blob].bounds;
+	//one pixel of background around the blob so findContours sees all its edges
+	mask.create(bounds.height + 2, bounds.width + 2, CV_8UC1);
+	mask.setTo(Scalar(0));
+	for(int i = firstRun[blob]; i < firstRun[blob + 1]; i++) {
+		const Run& run = runs[blobRuns[i]];
+		uchar* p = mask.ptr(run.y - bounds.y + 1);
+		std::fill(p + run.start - bounds.x + 1, p + run.end - bounds.x + 2, (uchar)255);
+	}
+	findContours(mask, traced, RETR_EXTERNAL, CV_CHAIN_APPROX_NONE, Point(bounds.x - 1, bounds.y - 1));
+	contour.clear();
+	if(!traced.empty()) {
+		contour.swap(traced[0]);
+	}
+}
+
+/**
+ * Trace the contours of the blobs whose enclosing circle can be larger than minRadius.
+ * The circle enclosing a blob is never larger than half the diagonal of its bounding
+ * rectangle, so all the smaller blobs are rejected without being traced.
+ */
+void BlobExtractor::traceLargeBlobs(float minRadius, std::vector<std::vector<Point> >& contours) {
+	contours.clear();
+	tracedBlobs.clear();
+	for(unsigned int b = 0; b < blobs.size(); b++) {
+		const Rect& bounds = blobs[b].bounds;
+		if(0.5 * std::sqrt((double)bounds.width * bounds.width + (double)bounds.height * bounds.height) <= minRadius) {
+			continue;
+		}
+		contours.push_back(std::vector<Point>());
+		traceContour(b, contours.back());
+		tracedBlobs.push_back(b);
+	}
+
+	//a blob in a hole of another blob has no outer contour of its own in findContours().
+	//The enclosing blob is larger, so it has been traced as well
+	enclosed.assign(contours.size(), false);
+	for(unsigned int i = 0; i < contours.size(); i++) {
+		if(contours[i].empty()) {
+			enclosed[i] = true;
+			continue;
+		}
+		const Rect& bounds = blobs[tracedBlobs[i]].bounds;
+		Point2f first(contours[i][0].x, contours[i][0].y);
+		for(unsigned int j = 0; j < contours.size() && !enclosed[i]; j++) {
+			const Rect& outer = blobs[tracedBlobs[j]].bounds;
+			enclosed[i] = j != i && (bounds & outer) == bounds && pointPolygonTest(contours[j], first, false) > 0;
+		}
+	}
+	unsigned int kept = 0;
+	for(unsigned int i = 0; i < contours.size(); i++) {
+		if(!enclosed[i]) {
+			if(kept != i) {
+				contours[kept].swap(contours[i]);
+			}
+			kept++;
+		}
+	}
+	contours.resize(kept);
+}
+
+/**
+ * Compare the blobs of a synthetic frame with components filled one by one with
+ * floodFill(), and the traced contours with findContours() on the whole frame.
+ * The frame has noise specks, overlapping hands and a blob in the hole of a ring.
+ * Its border is left clear because findContours() ignores the outermost pixels.
+ * Returns false on any difference.
+ */
+bool BlobExtractor::selfTest(std::ostream& out) {
+	Mat binary(374, 665, CV_8UC1, Scalar(0));
+	RNG rng(12345);
+	for(int i = 0; i < 300; i++) {
+		rectangle(binary, Rect(rng.uniform(0, binary.cols - 3), rng.uniform(0, binary.rows - 3), rng.uniform(1, 4), rng.uniform(1, 4)), Scalar(255), CV_FILLED);
+	}
+	for(int i = 0; i < 6; i++) {
+		ellipse(binary, Point(rng.uniform(0, binary.cols), rng.uniform(0, binary.rows)), Size(rng.uniform(20, 80), rng.uniform(20, 80)),
+				rng.uniform(0, 180), 0, 360, Scalar(255), CV_FILLED);
+	}
+	circle(binary, Point(500, 250), 80, Scalar(0), CV_FILLED);
+	circle(binary, Point(500, 250), 70, Scalar(255), 10);
+	circle(binary, Point(500, 250), 30, Scalar(255), CV_FILLED);
+	rectangle(binary, Rect(0, 0, binary.cols, binary.rows), Scalar(0), 1);
+
+	BlobExtractor extractor;
+	extractor.extract(binary);
+	const std::vector<BlobStats>& blobs = extractor.getBlobs();
+
+	bool passed = true;
+	int components = 0;
+	Mat labels = binary.clone();
+	Mat component;
+	for(int y = 0; y < labels.rows; y++) {
+		for(int x = 0; x < labels.cols; x++) {
+			if(labels.at<uchar>(y, x) != 255) {
+				continue;
+			}
+			Rect bounds;
+			int area = floodFill(labels, Point(x, y), Scalar(128), &bounds, Scalar(), Scalar(), 8);
+			compare(labels(bounds), Scalar(128), component, CMP_EQ);
+			Moments m = moments(component, true);
+			Mat filled = labels(bounds);
+			filled.setTo(Scalar(64), component);
+			components++;
+
+			bool found = false;
+			for(unsigned int b = 0; b < blobs.size() && !found; b++) {
+				found = blobs[b].bounds == bounds && blobs[b].area == area
+						&& std::abs(blobs[b].m10 - (m.m10 + bounds.x * m.m00)) < 0.5
+						&& std::abs(blobs[b].m01 - (m.m01 + bounds.y * m.m00)) < 0.5;
+			}
+			passed = passed && found;
+		}
+	}
+	passed = passed && components == (int)blobs.size();
+	out << "Blob extractor: " << blobs.size() << " blobs, floodFill found " << components << std::endl;
+
+	const float minRadius = 15;
+	std::vector<std::vector<Point> > contours, reference, large;
+	extractor.traceLargeBlobs(minRadius, contours);
+	Mat copy = binary.clone();
+	findContours(copy, reference, RETR_EXTERNAL, CV_CHAIN_APPROX_NONE);
+	for(unsigned int i = 0; i < reference.size(); i++) {
+		Rect bounds = boundingRect(Mat(reference[i]));
+		if(0.5 * std::sqrt((double)bounds.width * bounds.width + (double)bounds.height * bounds.height) > minRadius) {
+			large.push_back(reference[i]);
+		}
+	}
+	int matched = 0;
+	for(unsigned int i = 0; i < contours.size(); i++) {
+		for(unsigned int j = 0; j < large.size(); j++) {
+			if(contours[i] == large[j]) {
+				matched++;
+				break;
+			}
+		}
+	}
+	passed = passed && matched == (int)contours.size() && matched == (int)large.size();
+	out << "Blob extractor: " << contours.size() << " contours traced, " << matched << " of " << large.size() << " from findContours matched" << std::endl;
+	out << "Blob extractor self test " << (passed ? "passed" : "FAILED") << std::endl;
+	return passed;
+}
@@ -0,0 +1,78 @@
+/*
+ * BlobExtractor.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLOBEXTRACTOR_H_
+#define BLOBEXTRACTOR_H_
+
+#include "cv.h"
+#include <vector>
+#include <ostream>
+
+/**
+ * Statistics of one 8-connected component of a binary image
+ */
+struct BlobStats {
+	int area; //number of pixels, the zeroth moment
+	cv::Rect bounds; //bounding rectangle of the pixels
+	double m10; //sum of the x coordinates of the pixels
+	double m01; //sum of the y coordinates of the pixels
+	cv::Point2f centroid;
+};
+
+/**
+ * Finds the connected components (blobs) of a binary image in one pass over its runs
+ * of set pixels, merging touching runs with a union-find. Statistics of every blob come
+ * for free, so small noise blobs can be rejected before any contour is traced.
+ * Components are 8-connected like the outer contours of findContours().
+ */
+class BlobExtractor {
+
+public:
+	BlobExtractor();
+	void extract(const cv::Mat& binary);
+	const std::vector<BlobStats>& getBlobs();
+	void traceContour(int blob, std::vector<cv::Point>& contour);
+	void traceLargeBlobs(float minRadius, std::vector<std::vector<cv::Point> >& contours);
+	static bool selfTest(std::ostream& out);
+
+private:
+	struct Run {
+		int y;
+		int start; //first set pixel
+		int end; //last set pixel
+		int parent; //union-find parent, a run of the same blob found earlier
+	};
+
+	int root(int run);
+	void merge(int a, int b);
+
+	std::vector<Run> runs; //runs of set pixels in raster order
+	std::vector<BlobStats> blobs;
+	std::vector<int> blobOfRun;
+	std::vector<int> blobRuns; //runs grouped by blob
+	std::vector<int> firstRun; //index in blobRuns of the first run of each blob, plus an end marker
+	cv::Mat mask; //single blob image traced by traceContour()
+	std::vector<std::vector<cv::Point> > traced; //scratch output of findContours
+	std::vector<int> tracedBlobs; //blob of each contour of traceLargeBlobs()
+	std::vector<bool> enclosed; //contours of traceLargeBlobs() lying in a hole of another
+};
+
+#endif /* BLOBEXTRACTOR_H_ */
@@ -30,9 +30,29 @@ using namespace FlyCapture2;
 #define setting Setting::Instance()
 Undistortion* undistortion;
 
+CameraPGR::CameraPGR() {
+	do_undistortion = false;
+	is_color = false;
+	frameInterval = 0;
+	nextFrameTime = 0;
+	scale = 1;
+}
+
 CameraPGR::~CameraPGR() {
-	pgrCam.StopCapture();
-	pgrCam.Disconnect();
+	close();
+}
+
+/**
+ * Stop the capture thread and disconnect the camera. Safe to call more than once,
+ * the destructor calls it again at static destruction.
+ * */
+void CameraPGR::close() {
+	//the capture thread must not be inside RetrieveBuffer when the camera goes away
+	stopCapture();
+	if(pgrCam.IsConnected()) {
+		pgrCam.StopCapture();
+		pgrCam.Disconnect();
+	}
 }
 
 /**
@@ -134,15 +154,7 @@ void CameraPGR::init(int cam_index, bool do_undistortion, bool is_color){
 
     if(is_color) {
         //set framerate
-        prop.type = FRAME_RATE;
-        prop.autoManualMode = false;
-        prop.onOff = true;
-        prop.absValue = 15.0;
-        pgError = pgrCam.SetProperty( &prop );
-        if (pgError != PGRERROR_OK)
-        {
-            cout << "ERROR setting camera FPS" << endl;
-        }
+        setFrameRate(15.0);
         cout << "Color pgr camera [" << cam_index << "] successfully initialized." << endl;
     } else {
         //Main camera settings ...
@@ -185,27 +197,88 @@ void CameraPGR::init(int cam_index, bool do_undistortion, bool is_color){
 }
 
 /**
- * Retrieve an image from the camera and return it
+ * Ask the camera for framesPerSecond and deliver frames from grabImage() no faster
+ * than that, even if the camera does not support such a low rate. Sleeping between
+ * frames is enough because the camera only keeps its newest frame.
+ * */
+void CameraPGR::setFrameRate(float framesPerSecond) {
+    Property prop;
+    prop.type = FRAME_RATE;
+    prop.autoManualMode = false;
+    prop.onOff = true;
+    prop.absValue = framesPerSecond;
+    pgError = pgrCam.SetProperty( &prop );
+    if (pgError != PGRERROR_OK)
+    {
+        cout << "ERROR setting camera FPS" << endl;
+    }
+    fps = framesPerSecond;
+    frameInterval = framesPerSecond > 0 ? 1.0 / framesPerSecond : 0;
+    nextFrameTime = 0;
+}
+
+/**
+ * Downscale color frames by scale (e.g. 0.5) before they leave the capture thread.
+ * Values of 1 or more keep the full resolution.
+ * */
+void CameraPGR::setScale(float scale) {
+    this->scale = scale;
+}
+
+/**
+ * Retrieve an image from the camera and return it.
+ * All the intermediate images live in framePool so no memory is allocated once the
+ * first frame has been grabbed. The returned image is only valid until the next call.
  * */
 cv::Mat CameraPGR::grabImage(){
-    getOpenCVFromPGR();
-    big_image = cv::Mat(cv::Size(setting->pgr_cam_max_width, setting->pgr_cam_max_height), CV_8UC1);
-    roi_center = big_image(cv::Rect(56, 0, 640, 480));
-    image.copyTo(roi_center);
-    if(this->do_undistortion && setting->do_undistortion) {
-        undistortion->undistortImage(&big_image);
+    if(frameInterval > 0) {
+        double now = captureTime();
+        if(nextFrameTime == 0 || now > nextFrameTime + frameInterval) {
+            //first frame, or we fell behind: restart the schedule instead of catching up
+            nextFrameTime = now;
+        } else if(now < nextFrameTime) {
+            boost::this_thread::sleep(boost::posix_time::microseconds((long)((nextFrameTime - now) * 1e6)));
+        }
+        nextFrameTime += frameInterval;
     }
+    getOpenCVFromPGR();
     //TODO: fix this glocal crop. for now cropping all images to the ROI of source image
 
     if(is_color) {
+        cv::Mat& flippedImage = framePool.buffer(POOL_FLIPPED, image.size(), image.type());
         cv::flip(image, flippedImage, 1);
-        croppedImage = flippedImage(cv::Rect(0, 0, setting->imageSizeX, setting->imageSizeY));
-        return croppedImage;
-    } else {
-        cv::flip(big_image, flippedImage, 1);
-        croppedImage = flippedImage(cv::Rect(setting->imageOffsetX, setting->imageOffsetY, setting->imageSizeX, setting->imageSizeY));
-        return croppedImage;
+        cv::Mat cropped = flippedImage(cv::Rect(0, 0, setting->imageSizeX, setting->imageSizeY));
+        if(scale < 1) {
+            cv::Size scaledSize(cvRound(cropped.cols * scale), cvRound(cropped.rows * scale));
+            cv::Mat& scaledImage = framePool.buffer(POOL_SCALED, scaledSize, image.type());
+            cv::resize(cropped, scaledImage, scaledSize, 0, 0, cv::INTER_AREA);
+            framePool.checkpoint();
+            return scaledImage;
+        }
+        framePool.checkpoint();
+        return cropped;
+    }
+
+    if(this->do_undistortion && setting->do_undistortion && setting->undistortion_mode != "points") {
+        //undistort, flip and crop in a single pass over the sensor image
+        cv::Size roiSize(setting->imageSizeX, setting->imageSizeY);
+        cv::Mat& undistortedImage = framePool.buffer(POOL_UNDISTORTED, roiSize, image.type());
+        undistortion->remapToROI(image, undistortedImage);
+        framePool.checkpoint();
+        return undistortedImage;
     }
+
+    //centre the sensor image in a bigger (752x480) container to match the undistorted geometry
+    cv::Size bigSize(setting->pgr_cam_max_width, setting->pgr_cam_max_height);
+    cv::Mat& bigImage = framePool.buffer(POOL_PADDED, bigSize, image.type());
+    cv::Rect center((bigSize.width - image.cols) / 2, (bigSize.height - image.rows) / 2, image.cols, image.rows);
+    cv::Mat roiCenter = bigImage(center);
+    image.copyTo(roiCenter);
+
+    cv::Mat& flippedImage = framePool.buffer(POOL_FLIPPED, bigSize, image.type());
+    cv::flip(bigImage, flippedImage, 1);
+    framePool.checkpoint();
+    return flippedImage(cv::Rect(setting->imageOffsetX, setting->imageOffsetY, setting->imageSizeX, setting->imageSizeY));
 }
 
 void CameraPGR::calibrateUndistortionROI() {
@@ -214,12 +287,33 @@ void CameraPGR::calibrateUndistortionROI() {
 	undistortion = new Undistortion();
 }
 
+/**
+ * In "points" undistortion mode frames from this camera are left distorted and the
+ * returned object is used to undistort tracked coordinates instead.
+ * Returns NULL when this camera's coordinates need no undistortion.
+ * The object is replaced by calibrateUndistortionROI().
+ * */
+Undistortion* CameraPGR::getPointUndistortion() {
+	if(this->do_undistortion && setting->do_undistortion && setting->undistortion_mode == "points") {
+		return undistortion;
+	}
+	return NULL;
+}
+
+/**
+ * Number of frame buffers allocated by grabImage() so far. This stays constant once
+ * capturing is running, unless the ROI is changed.
+ * */
+unsigned long CameraPGR::getAllocationCount() {
+	return framePool.getAllocationCount();
+}
+
 /**
  * Convert PGR image to appropriate OpenCV image format
  * */
 void CameraPGR::getOpenCVFromPGR(){
-    pImage.ReleaseBuffer();
-    //image.release();
+    //pImage keeps its buffer between frames, releasing it here would mean
+    //a new allocation inside RetrieveBuffer for every frame
 
     pgError = pgrCam.RetrieveBuffer(&pImage);
     if (pgError != PGRERROR_OK){
@@ -233,7 +327,7 @@ void CameraPGR::getOpenCVFromPGR(){
 	{
 		case PIXEL_FORMAT_MONO8:
             //good old single chanel 8bit monochrome
-            image = cv::Mat(rows, cols, CV_8UC1 , pImage.GetData());
+            wrapBuffer(rows, cols, CV_8UC1, &pImage);
 			break;
 		case PIXEL_FORMAT_411YUV8:
 		case PIXEL_FORMAT_422YUV8:
@@ -243,19 +337,19 @@ void CameraPGR::getOpenCVFromPGR(){
         case PIXEL_FORMAT_BGR:
             //8bit color image
             pImage.Convert(PIXEL_FORMAT_BGR, &colorImage);
-            image = cv::Mat(rows, cols, CV_8UC3 , colorImage.GetData());
+            wrapBuffer(rows, cols, CV_8UC3, &colorImage);
 			break;
 		case PIXEL_FORMAT_MONO16:
         case PIXEL_FORMAT_S_MONO16:
             //16bit monochrome image single chanel
-            image = cv::Mat(rows, cols, CV_16UC1 , pImage.GetData());
+            wrapBuffer(rows, cols, CV_16UC1, &pImage);
 			break;
 		case PIXEL_FORMAT_RGB16:
         case PIXEL_FORMAT_RAW16:
 		case PIXEL_FORMAT_S_RGB16:
             //16bit color
             pImage.Convert(PIXEL_FORMAT_BGR, &colorImage);
-            image = cv::Mat(rows, cols, CV_16UC3 , colorImage.GetData());
+            wrapBuffer(rows, cols, CV_16UC3, &colorImage);
 			break;
 		case PIXEL_FORMAT_MONO12:
         case PIXEL_FORMAT_RAW12:
@@ -265,7 +359,7 @@ void CameraPGR::getOpenCVFromPGR(){
 		case PIXEL_FORMAT_RGBU:
             //8bit  four chanel color image
             pImage.Convert(PIXEL_FORMAT_BGRU, &colorImage);
-            image = cv::Mat(rows, cols, CV_8UC4 , colorImage.GetData());
+            wrapBuffer(rows, cols, CV_8UC4, &colorImage);
 			break;
 		default:
 			cout << "ERROR in detecting image format" << endl;
@@ -273,6 +367,17 @@ void CameraPGR::getOpenCVFromPGR(){
 	}
 }
 
+/**
+ * Point image at the pixels of a FlyCapture image without copying them.
+ * The header is only rebuilt when the buffer moves or changes shape.
+ * */
+void CameraPGR::wrapBuffer(unsigned int rows, unsigned int cols, int type, Image* buffer) {
+    unsigned char* data = buffer->GetData();
+    if(image.data != data || image.rows != (int)rows || image.cols != (int)cols || image.type() != type) {
+        image = cv::Mat(rows, cols, type, data, buffer->GetStride());
+    }
+}
+
 void CameraPGR::PrintCameraInfo( CameraInfo* pCamInfo ) {
     printf(
         "\n*** CAMERA INFORMATION ***\n"
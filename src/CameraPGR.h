@@ -26,20 +26,32 @@
 #include "cv.h"
 
 #include "ImageProvider.h"
+#include "FramePool.h"
 
 using namespace FlyCapture2;
 
+class Undistortion;
 
 class CameraPGR : public ImageProvider {
 
 public:
+	CameraPGR();
 	cv::Mat grabImage();
     void init(int cam_index, bool do_undistortion, bool is_color);
+    void setFrameRate(float framesPerSecond);
+    void setScale(float scale);
 	void calibrateUndistortionROI();
+	unsigned long getAllocationCount();
+	Undistortion* getPointUndistortion();
+	void close();
 	~CameraPGR();
 
 private:
+    //buffers of framePool used by grabImage()
+    enum { POOL_PADDED, POOL_UNDISTORTED, POOL_FLIPPED, POOL_SCALED };
+
     void getOpenCVFromPGR();
+    void wrapBuffer(unsigned int rows, unsigned int cols, int type, Image* buffer);
     void PrintCameraInfo( CameraInfo* pCamInfo );
     //unsigned char pMemBuffers;
     PixelFormat pixFormat;
@@ -47,11 +59,8 @@ private:
     Error pgError;
     Image pImage;
     Image colorImage; //new image to be referenced by cvImage for converting to color
-    cv::Mat image;
-    cv::Mat big_image; //bigger (752x480) container for image for undistortion
-    cv::Mat roi_center;
-    cv::Mat flippedImage;
-    cv::Mat croppedImage;
+    cv::Mat image; //header wrapping the FlyCapture buffer, no pixels are copied
+    FramePool framePool; //padded (752x480), undistorted and flipped images reused every frame
 	Camera pgrCam;
 	PGRGuid guid;
     Format7ImageSettings fmt7ImageSettings;
@@ -62,6 +71,9 @@ private:
     //note that there is also a global setting->do_undistortion that applies to all cameras
     bool do_undistortion;
     bool is_color;
+    double frameInterval; //seconds between frames handed out by grabImage(), 0 for the camera's own rate
+    double nextFrameTime; //time at which grabImage() should return the next frame
+    float scale; //color frames are downscaled by this factor when it is below 1
 };
 
 #endif /* CAMERAPGR_H_ */
@@ -0,0 +1,128 @@
+/*
+ * DepthSampler.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DepthSampler.h"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace cv;
+
+DepthSampler::DepthSampler() {
+}
+
+/**
+ * Prepare to sample image. Integrals are only computed over regions grown by margin,
+ * or over the whole image when there are no regions
+ */
+void DepthSampler::setImage(const Mat& image, const std::vector<Rect>& regions, int margin) {
+	this->image = image;
+	Rect frame(0, 0, image.cols, image.rows);
+	areas.clear();
+	if(regions.empty()) {
+		areas.push_back(frame);
+	}
+	for(unsigned int i = 0; i < regions.size(); i++) {
+		Rect area = Rect(regions[i].x - margin, regions[i].y - margin, regions[i].width + 2 * margin,
+				regions[i].height + 2 * margin) & frame;
+		if(area.area() > 0) {
+			areas.push_back(area);
+		}
+	}
+
+	if(buffers.size() < areas.size()) {
+		buffers.resize(areas.size());
+	}
+	sums.resize(areas.size());
+	for(unsigned int i = 0; i < areas.size(); i++) {
+		if(buffers[i].rows != image.rows + 1 || buffers[i].cols != image.cols + 1) {
+			buffers[i].create(image.rows + 1, image.cols + 1, CV_32SC1);
+		}
+		sums[i] = buffers[i](Rect(0, 0, areas[i].width + 1, areas[i].height + 1));
+		integral(image(areas[i]), sums[i], CV_32S);
+	}
+}
+
+/**
+ * Mean of the size x size window of the image centred on center, clamped to the image.
+ * Returns -1 if the window is completely outside the image
+ */
+float DepthSampler::sample(Point2f center, int size) {
+	Rect window = Rect(int(center.x - size/2), int(center.y - size/2), size, size) & Rect(0, 0, image.cols, image.rows);
+	if(window.area() == 0) {
+		return -1;
+	}
+	for(unsigned int i = 0; i < areas.size(); i++) {
+		if((window & areas[i]) != window) {
+			continue;
+		}
+		int x0 = window.x - areas[i].x, y0 = window.y - areas[i].y;
+		int x1 = x0 + window.width, y1 = y0 + window.height;
+		const Mat& sum = sums[i];
+		int total = sum.at<int>(y1, x1) - sum.at<int>(y0, x1) - sum.at<int>(y1, x0) + sum.at<int>(y0, x0);
+		return (float)total / window.area();
+	}
+	//not near a hand, which only happens to features that belong to no hand
+	return (float)mean(image(window)).val[0];
+}
+
+/**
+ * Compare sample() with cv::mean over the same clamped window on random images, with
+ * hand regions inside the image and across its border, with no regions at all and
+ * for windows away from every region. Returns false if any mean differs by more than
+ * float rounding.
+ */
+bool DepthSampler::selfTest(std::ostream& out) {
+	Mat image(374, 665, CV_8UC1);
+	RNG rng(12345);
+	rng.fill(image, RNG::UNIFORM, Scalar(0), Scalar(256));
+	Rect frame(0, 0, image.cols, image.rows);
+	std::vector<Rect> regions;
+	regions.push_back(Rect(120, 80, 150, 170));
+	regions.push_back(Rect(560, 250, 140, 160)); //crosses the bottom right corner
+	std::vector<Rect> none;
+	const int size = 26;
+
+	DepthSampler sampler;
+	double maxDifference = 0;
+	int samples = 0;
+	for(int pass = 0; pass < 2; pass++) {
+		sampler.setImage(image, pass == 0 ? regions : none, size / 2 + 1);
+		for(int i = 0; i < 2000; i++) {
+			Point2f center;
+			if(i % 4 == 3) {
+				//anywhere, including outside the image and away from the regions
+				center = Point2f(rng.uniform(-20.0f, image.cols + 20.0f), rng.uniform(-20.0f, image.rows + 20.0f));
+			} else {
+				const Rect& region = regions[i % 2];
+				center = Point2f(rng.uniform((float)region.x, (float)region.br().x), rng.uniform((float)region.y, (float)region.br().y));
+			}
+			Rect window = Rect(int(center.x - size/2), int(center.y - size/2), size, size) & frame;
+			float expected = window.area() == 0 ? -1 : (float)mean(image(window)).val[0];
+			maxDifference = std::max(maxDifference, (double)std::abs(sampler.sample(center, size) - expected));
+			samples++;
+		}
+	}
+	bool passed = maxDifference <= 1e-3;
+	out << "Depth sampler: " << samples << " windows, max difference from cv::mean = " << maxDifference << std::endl;
+	out << "Depth sampler self test " << (passed ? "passed" : "FAILED") << std::endl;
+	return passed;
+}
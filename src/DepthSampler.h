@@ -0,0 +1,51 @@
+/*
+ * DepthSampler.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEPTHSAMPLER_H_
+#define DEPTHSAMPLER_H_
+
+#include "cv.h"
+#include <vector>
+#include <ostream>
+
+/**
+ * Mean of square windows of the touch image in constant time. One integral image is
+ * kept per hand region, grown by a margin so every window centred in a hand fits in
+ * it, and a window mean is a four tap lookup. Windows are clamped to the image instead
+ * of being rejected at the border.
+ * Integral buffers are frame sized and reused, only the part a region needs is written.
+ */
+class DepthSampler {
+
+public:
+	DepthSampler();
+	void setImage(const cv::Mat& image, const std::vector<cv::Rect>& regions, int margin);
+	float sample(cv::Point2f center, int size);
+	static bool selfTest(std::ostream& out);
+
+private:
+	cv::Mat image; //touch image of the last setImage()
+	std::vector<cv::Rect> areas; //parts of image covered by an integral
+	std::vector<cv::Mat> buffers; //frame sized integral buffers, one per area
+	std::vector<cv::Mat> sums; //integral of each area, a corner of its buffer
+};
+
+#endif /* DEPTHSAMPLER_H_ */
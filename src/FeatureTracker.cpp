@@ -0,0 +1,155 @@
+/*
+ * FeatureTracker.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FeatureTracker.h"
+
+using namespace cv;
+
+FeatureTracker::FeatureTracker() {
+	nextId = 0;
+	detections = 0;
+	pyramidCount = 0;
+	pyramidBuilt[0] = pyramidBuilt[1] = false;
+	pyramidFrame[0] = pyramidFrame[1] = 0;
+	setDetection(0.01, 10, 26);
+	setFlow(Size(26, 26), 1, TermCriteria(CV_TERMCRIT_NUMBER | CV_TERMCRIT_EPS, 10, 0.3), 1e-4);
+}
+
+/**
+ * Parameters of goodFeaturesToTrack used by detect()
+ */
+void FeatureTracker::setDetection(double qualityLevel, double minDistance, int blockSize) {
+	this->qualityLevel = qualityLevel;
+	this->minDistance = minDistance;
+	this->blockSize = blockSize;
+}
+
+/**
+ * Parameters of calcOpticalFlowPyrLK used by track(). maxLevel is the index of the
+ * coarsest pyramid level, 0 for no pyramid
+ */
+void FeatureTracker::setFlow(Size window, int maxLevel, TermCriteria criteria, double minEigThreshold) {
+	this->window = window;
+	this->maxLevel = maxLevel;
+	this->criteria = criteria;
+	this->minEigThreshold = minEigThreshold;
+	//pyramids are padded for the window, so they cannot be reused with new parameters
+	pyramidBuilt[0] = pyramidBuilt[1] = false;
+}
+
+/**
+ * Optical flow pyramid of image, which is frame number frame. The pyramid is only
+ * built the first time it is asked for
+ */
+const std::vector<Mat>& FeatureTracker::pyramid(const Mat& image, unsigned long frame) {
+	int slot = frame % 2;
+	if(!pyramidBuilt[slot] || pyramidFrame[slot] != frame) {
+		buildOpticalFlowPyramid(image, pyramids[slot], window, maxLevel);
+		pyramidBuilt[slot] = true;
+		pyramidFrame[slot] = frame;
+		pyramidCount++;
+	}
+	return pyramids[slot];
+}
+
+/**
+ * Follow every track from previousImage to currentImage, which is frame number frame.
+ * Tracks the flow loses or that leave the image are dropped, the others get one frame older.
+ * The pyramid of currentImage is always built, since the next frame needs it.
+ */
+void FeatureTracker::track(const Mat& previousImage, const Mat& currentImage, unsigned long frame) {
+	const std::vector<Mat>& currentPyramid = pyramid(currentImage, frame);
+	if(tracks.empty()) {
+		return;
+	}
+	if(previousImage.size() != currentImage.size() || previousImage.empty() || frame == 0) {
+		//nothing to follow the features from
+		clear();
+		return;
+	}
+	from.resize(tracks.size());
+	for(unsigned int i = 0; i < tracks.size(); i++) {
+		from[i] = tracks[i].position;
+	}
+	const std::vector<Mat>& previousPyramid = pyramid(previousImage, frame - 1);
+	calcOpticalFlowPyrLK(previousPyramid, currentPyramid, from, to, status, error, window, maxLevel, criteria, 0, minEigThreshold);
+
+	Rect bounds(0, 0, currentImage.cols, currentImage.rows);
+	unsigned int kept = 0;
+	for(unsigned int i = 0; i < tracks.size(); i++) {
+		if(status[i] == 0 || !bounds.contains(Point(cvFloor(to[i].x), cvFloor(to[i].y)))) {
+			continue;
+		}
+		FeatureTrack& track = tracks[kept++];
+		track = tracks[i];
+		track.previous = from[i];
+		track.position = to[i];
+		track.age++;
+	}
+	tracks.resize(kept);
+}
+
+/**
+ * Start up to wanted new tracks at the strongest corners of image inside region and mask,
+ * away from the live tracks. Corners are only searched for in region, so detecting for
+ * one hand costs as much as its bounding box. Returns the number of tracks added.
+ */
+int FeatureTracker::detect(const Mat& image, const Mat& mask, Rect region, int wanted) {
+	region &= Rect(0, 0, image.cols, image.rows);
+	if(wanted <= 0 || region.area() == 0) {
+		return 0;
+	}
+	mask(region).copyTo(detectionMask);
+	for(unsigned int i = 0; i < tracks.size(); i++) {
+		circle(detectionMask, tracks[i].position - Point2f(region.x, region.y), cvRound(minDistance), Scalar(0), CV_FILLED);
+	}
+	goodFeaturesToTrack(image(region), found, wanted, qualityLevel, minDistance, detectionMask, blockSize, false);
+	detections++;
+	for(unsigned int i = 0; i < found.size(); i++) {
+		FeatureTrack track;
+		track.id = nextId++;
+		track.previous = found[i] + Point2f(region.x, region.y);
+		track.position = track.previous;
+		track.age = 0;
+		track.hand = 0;
+		tracks.push_back(track);
+	}
+	return found.size();
+}
+
+void FeatureTracker::clear() {
+	tracks.clear();
+}
+
+/**
+ * Live tracks, oldest first. Callers may update the hand of each track
+ */
+std::vector<FeatureTrack>& FeatureTracker::getTracks() {
+	return tracks;
+}
+
+unsigned long FeatureTracker::getDetectionCount() {
+	return detections;
+}
+
+unsigned long FeatureTracker::getPyramidCount() {
+	return pyramidCount;
+}
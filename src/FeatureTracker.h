@@ -0,0 +1,86 @@
+/*
+ * FeatureTracker.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FEATURETRACKER_H_
+#define FEATURETRACKER_H_
+
+#include "cv.h"
+#include <vector>
+
+/**
+ * One feature followed across frames
+ */
+struct FeatureTrack {
+	int id; //unique for the life of the tracker
+	cv::Point2f previous; //position in the previous frame, equal to position on the frame it was detected
+	cv::Point2f position; //position in the current frame
+	int age; //number of frames the feature has been followed by optical flow
+	int hand; //hand the feature was in when last assigned: 0 none, 1 hand one, 2 hand two
+};
+
+/**
+ * Keeps features alive across frames with pyramidal Lucas-Kanade optical flow.
+ * Features that are lost are dropped and new ones are only detected on request,
+ * so every track has a stable id and a real age.
+ * The pyramid of each frame is built once and kept for the next frame, where it is
+ * the pyramid of the previous image.
+ */
+class FeatureTracker {
+
+public:
+	FeatureTracker();
+	void setDetection(double qualityLevel, double minDistance, int blockSize);
+	void setFlow(cv::Size window, int maxLevel, cv::TermCriteria criteria, double minEigThreshold);
+	void track(const cv::Mat& previousImage, const cv::Mat& currentImage, unsigned long frame);
+	int detect(const cv::Mat& image, const cv::Mat& mask, cv::Rect region, int wanted);
+	void clear();
+	std::vector<FeatureTrack>& getTracks();
+	unsigned long getDetectionCount();
+	unsigned long getPyramidCount();
+
+private:
+	std::vector<FeatureTrack> tracks;
+	int nextId;
+	unsigned long detections; //number of times detect() ran goodFeaturesToTrack
+
+	double qualityLevel;
+	double minDistance;
+	int blockSize;
+	cv::Size window;
+	int maxLevel;
+	cv::TermCriteria criteria;
+	double minEigThreshold; //tracks whose flow matrix has a smaller minimum eigenvalue are lost
+
+	const std::vector<cv::Mat>& pyramid(const cv::Mat& image, unsigned long frame);
+
+	std::vector<cv::Mat> pyramids[2]; //optical flow pyramids of the last two frames, indexed by frame % 2
+	bool pyramidBuilt[2];
+	unsigned long pyramidFrame[2]; //frame each pyramid was built for
+	unsigned long pyramidCount; //number of pyramids built
+	std::vector<cv::Point2f> from; //positions passed to and returned by optical flow
+	std::vector<cv::Point2f> to;
+	std::vector<uchar> status;
+	std::vector<float> error;
+	std::vector<cv::Point2f> found; //corners found by detect()
+	cv::Mat detectionMask; //mask of the region of detect() without the neighbourhood of live tracks
+};
+
+#endif /* FEATURETRACKER_H_ */
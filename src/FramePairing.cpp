@@ -0,0 +1,60 @@
+/*
+ * FramePairing.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FramePairing.h"
+
+#include <cmath>
+
+FramePairing::FramePairing(int historySize) : history(std::max(historySize, 1)) {
+	next = 0;
+	count = 0;
+}
+
+/**
+ * Copy every frame source has captured since the last call into the history.
+ * Returns immediately when there is none.
+ * */
+void FramePairing::collect(ImageProvider& source) {
+	const Frame* frame;
+	while((frame = source.tryNextFrame(FRAME_POLICY_EVERY)) != NULL) {
+		Frame& slot = history[next];
+		frame->image.copyTo(slot.image);
+		slot.sequence = frame->sequence;
+		slot.timestamp = frame->timestamp;
+		next = (next + 1) % history.size();
+		count = std::min(count + 1, (int)history.size());
+	}
+}
+
+/**
+ * Return the collected frame captured closest to timestamp, or NULL if nothing has
+ * been collected yet. The frame stays valid until the next call to collect().
+ * */
+const Frame* FramePairing::nearest(double timestamp) {
+	const Frame* best = NULL;
+	for(int i = 0; i < count; i++) {
+		const Frame& candidate = history[i];
+		if(best == NULL || std::fabs(candidate.timestamp - timestamp) < std::fabs(best->timestamp - timestamp)) {
+			best = &candidate;
+		}
+	}
+	return best;
+}
@@ -0,0 +1,49 @@
+/*
+ * FramePairing.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMEPAIRING_H_
+#define FRAMEPAIRING_H_
+
+#include "cv.h"
+#include <vector>
+
+#include "ImageProvider.h"
+
+/**
+ * Pairs frames of a secondary camera with the frames of the tracker by capture time.
+ * The secondary camera captures on its own thread at its own rate; collect() copies
+ * whatever it has produced into a short history without ever waiting for it, and
+ * nearest() picks the frame of that history closest in time to a tracker frame.
+ */
+class FramePairing {
+
+public:
+	FramePairing(int historySize);
+	void collect(ImageProvider& source);
+	const Frame* nearest(double timestamp);
+
+private:
+	std::vector<Frame> history; //most recent frames of the secondary camera
+	int next; //slot of history the next collected frame goes to
+	int count; //number of valid frames in history
+};
+
+#endif /* FRAMEPAIRING_H_ */
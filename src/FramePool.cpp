@@ -0,0 +1,66 @@
+/*
+ * FramePool.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FramePool.h"
+
+FramePool::FramePool() {
+	allocations = 0;
+}
+
+/**
+ * Return buffer id with the given size and type. The buffer is only (re)allocated
+ * the first time it is requested or when size or type change, and new buffers are
+ * zeroed so padding never contains garbage.
+ */
+cv::Mat& FramePool::buffer(int id, cv::Size size, int type) {
+	if(id >= (int)buffers.size()) {
+		buffers.resize(id + 1);
+		lastData.resize(id + 1, NULL);
+	}
+	cv::Mat& b = buffers[id];
+	if(b.size() != size || b.type() != type) {
+		b.create(size, type);
+		b.setTo(cv::Scalar::all(0));
+		allocations.fetch_add(1, boost::memory_order_relaxed);
+	}
+	lastData[id] = b.data;
+	return b;
+}
+
+/**
+ * Call once per frame after all the buffers have been written. Any buffer that an
+ * OpenCV function had to reallocate behind our back is counted as an allocation.
+ */
+void FramePool::checkpoint() {
+	for(unsigned int i = 0; i < buffers.size(); i++) {
+		if(buffers[i].data != lastData[i]) {
+			allocations.fetch_add(1, boost::memory_order_relaxed);
+			lastData[i] = buffers[i].data;
+		}
+	}
+}
+
+/**
+ * Total number of frame buffer allocations made by the owner of this pool
+ */
+unsigned long FramePool::getAllocationCount() {
+	return allocations.load(boost::memory_order_relaxed);
+}
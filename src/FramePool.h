@@ -0,0 +1,51 @@
+/*
+ * FramePool.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMEPOOL_H_
+#define FRAMEPOOL_H_
+
+#include "cv.h"
+#include <vector>
+#include <boost/atomic.hpp>
+
+/**
+ * A set of image buffers owned by one image source and reused for every frame.
+ * Each buffer is identified by a small integer chosen by the owner. The pool counts
+ * every allocation it makes or detects, so in steady state the count must stay constant.
+ */
+class FramePool {
+
+public:
+	FramePool();
+	cv::Mat& buffer(int id, cv::Size size, int type);
+	void checkpoint();
+	unsigned long getAllocationCount();
+
+private:
+	std::vector<cv::Mat> buffers;
+	std::vector<uchar*> lastData; //data pointer of each buffer at the previous checkpoint
+	boost::atomic<unsigned long> allocations;
+
+	FramePool(const FramePool&); //Prevent copy-construction
+	FramePool& operator=(const FramePool&); //Prevent assignment
+};
+
+#endif /* FRAMEPOOL_H_ */
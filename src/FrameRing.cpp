@@ -0,0 +1,176 @@
+/*
+ * FrameRing.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FrameRing.h"
+
+#include <time.h>
+
+/**
+ * Return the current time in seconds on a monotonic clock. This is the clock
+ * used to stamp every captured frame so differences between stamps are always valid
+ */
+double captureTime() {
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * Allocate all the slots of the ring up front so capturing a frame never allocates.
+ * One slot more than capacity is allocated for the frame the producer is filling
+ */
+FrameRing::FrameRing(int capacity, cv::Size size, int type) : slots(capacity + 1), claimed(capacity + 1) {
+	this->capacity = capacity;
+	int count = slots.size();
+	unread.reset(new boost::atomic<int>[count]);
+	released.reset(new boost::atomic<int>[count]);
+	unreadHead = 0;
+	unreadTail = 0;
+	//every slot starts out released, so the producer can take them in order
+	for(int i = 0; i < count; i++) {
+		unread[i] = -1;
+		released[i] = i;
+	}
+	releasedHead = count;
+	releasedTail = 0;
+	writing = -1;
+	reading = -1;
+	dropped = 0;
+	skipped = 0;
+	for(int i = 0; i < count; i++) {
+		slots[i].image.create(size, type);
+		slots[i].sequence = 0;
+		slots[i].timestamp = 0;
+	}
+}
+
+/**
+ * Producer side: return the slot to fill next or NULL if the ring is full.
+ * With FRAME_POLICY_LATEST a full ring recycles its oldest unread frame instead, so the
+ * newest frame is never the one thrown away. The slot is not visible to the consumer
+ * until endWrite() is called
+ */
+Frame* FrameRing::beginWrite(framePolicy policy) {
+	unsigned long r = releasedTail.load(boost::memory_order_relaxed);
+	if(r != releasedHead.load(boost::memory_order_acquire)) {
+		writing = released[r % slots.size()].load(boost::memory_order_relaxed);
+		releasedTail.store(r + 1, boost::memory_order_release);
+		return &slots[writing];
+	}
+	if(policy != FRAME_POLICY_LATEST) {
+		return NULL;
+	}
+	//take the oldest unread slot before the consumer does
+	unsigned long h = unreadHead.load(boost::memory_order_relaxed);
+	unsigned long t = unreadTail.load(boost::memory_order_acquire);
+	while(t != h) {
+		int slot = unread[t % slots.size()].load(boost::memory_order_relaxed);
+		if(unreadTail.compare_exchange_weak(t, t + 1, boost::memory_order_acq_rel)) {
+			dropped.fetch_add(1, boost::memory_order_relaxed);
+			writing = slot;
+			return &slots[writing];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Producer side: publish the slot returned by beginWrite()
+ */
+void FrameRing::endWrite() {
+	unsigned long h = unreadHead.load(boost::memory_order_relaxed);
+	unread[h % slots.size()].store(writing, boost::memory_order_relaxed);
+	unreadHead.store(h + 1, boost::memory_order_release);
+	writing = -1;
+}
+
+/**
+ * Consumer side: return the next frame to process or NULL if there is none yet.
+ * With FRAME_POLICY_LATEST any older frames waiting in the ring are released unseen.
+ * The frame stays valid until endRead() is called
+ */
+const Frame* FrameRing::beginRead(framePolicy policy) {
+	unsigned long t = unreadTail.load(boost::memory_order_acquire);
+	for(;;) {
+		unsigned long h = unreadHead.load(boost::memory_order_acquire);
+		if(t == h) {
+			return NULL;
+		}
+		if(h - t > slots.size()) {
+			//t went stale while the producer recycled and wrote several frames
+			t = unreadTail.load(boost::memory_order_acquire);
+			continue;
+		}
+		unsigned long last = policy == FRAME_POLICY_LATEST ? h - 1 : t;
+		//the entries have to be read before the claim, afterwards the producer may reuse them
+		for(unsigned long i = t; i <= last; i++) {
+			claimed[i - t] = unread[i % slots.size()].load(boost::memory_order_relaxed);
+		}
+		if(unreadTail.compare_exchange_weak(t, last + 1, boost::memory_order_acq_rel)) {
+			int count = last - t;
+			for(int i = 0; i < count; i++) {
+				unsigned long e = releasedHead.load(boost::memory_order_relaxed);
+				released[e % slots.size()].store(claimed[i], boost::memory_order_relaxed);
+				releasedHead.store(e + 1, boost::memory_order_release);
+			}
+			skipped += count;
+			reading = claimed[count];
+			return &slots[reading];
+		}
+		//the producer recycled the oldest frame meanwhile, t now holds the new tail
+	}
+}
+
+/**
+ * Consumer side: hand the slot returned by beginRead() back to the producer
+ */
+void FrameRing::endRead() {
+	if(reading < 0) {
+		return;
+	}
+	unsigned long e = releasedHead.load(boost::memory_order_relaxed);
+	released[e % slots.size()].store(reading, boost::memory_order_relaxed);
+	releasedHead.store(e + 1, boost::memory_order_release);
+	reading = -1;
+}
+
+int FrameRing::getCapacity() {
+	return capacity;
+}
+
+/**
+ * Number of frames thrown away by the producer because the consumer fell behind
+ */
+unsigned long FrameRing::getDroppedFrames() {
+	return dropped.load(boost::memory_order_relaxed);
+}
+
+/**
+ * Number of frames the consumer skipped to stay on the latest frame.
+ * Only meaningful when read from the consumer thread
+ */
+unsigned long FrameRing::getSkippedFrames() {
+	return skipped;
+}
+
+void FrameRing::countDroppedFrame() {
+	dropped.fetch_add(1, boost::memory_order_relaxed);
+}
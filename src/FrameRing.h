@@ -0,0 +1,87 @@
+/*
+ * FrameRing.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMERING_H_
+#define FRAMERING_H_
+
+#include "cv.h"
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+
+/**
+ * One captured image together with its place in the capture stream
+ */
+struct Frame {
+	cv::Mat image;
+	unsigned long sequence; //increasing number assigned by the capture thread
+	double timestamp; //capture time in seconds as returned by captureTime()
+};
+
+typedef enum _framePolicy {
+	FRAME_POLICY_LATEST, //always process the newest frame and skip any backlog
+	FRAME_POLICY_EVERY //process every captured frame in order
+} framePolicy;
+
+double captureTime();
+
+/**
+ * Fixed size single producer / single consumer ring of preallocated frames.
+ * The capture thread is the only writer and the processing loop the only reader,
+ * and no locks are used. Slots travel between the two sides as indices through two
+ * queues with atomic counters: unread slots in capture order to the consumer and
+ * released slots back to the producer. Both sides may pop the oldest unread slot,
+ * with a compare and swap on its counter, so the producer can recycle it under
+ * FRAME_POLICY_LATEST while the slot the consumer holds is in neither queue.
+ */
+class FrameRing {
+
+public:
+	FrameRing(int capacity, cv::Size size, int type);
+	Frame* beginWrite(framePolicy policy);
+	void endWrite();
+	const Frame* beginRead(framePolicy policy);
+	void endRead();
+	int getCapacity();
+	unsigned long getDroppedFrames();
+	unsigned long getSkippedFrames();
+	void countDroppedFrame();
+
+private:
+	std::vector<Frame> slots;
+	int capacity;
+	boost::scoped_array<boost::atomic<int> > unread; //unread slots in capture order, circular
+	boost::atomic<unsigned long> unreadHead; //number of slots queued, owned by the producer
+	boost::atomic<unsigned long> unreadTail; //number of slots taken, by either side with compare and swap
+	boost::scoped_array<boost::atomic<int> > released; //slots the consumer is done with, circular
+	boost::atomic<unsigned long> releasedHead; //number of slots released, owned by the consumer
+	boost::atomic<unsigned long> releasedTail; //number of slots reused, owned by the producer
+	std::vector<int> claimed; //slots taken by one beginRead(), oldest first, consumer only
+	int writing; //slot being filled by the producer, -1 if none
+	int reading; //slot held by the consumer, -1 if none
+	boost::atomic<unsigned long> dropped; //frames lost because the ring was full
+	unsigned long skipped; //frames the consumer jumped over with FRAME_POLICY_LATEST
+
+	FrameRing(const FrameRing&); //Prevent copy-construction
+	FrameRing& operator=(const FrameRing&); //Prevent assignment
+};
+
+#endif /* FRAMERING_H_ */
@@ -23,12 +23,20 @@
 
 #include "GestureTracker.h"
 #include "GibbonMain.h"
+#include "Setting.h"
 #include "Log.h"
 
-void GestureTracker::checkGestures(vector<Hand>* h) {
+#define setting Setting::Instance()
 
-	if(checkGrabRelease(h))
+void GestureTracker::checkGestures(HandHistory* h) {
+
+	if(h->current().hasFlow()) {
+		//dense flow is far less noisy than the handful of tracked features
+		if(checkFlowGrabRelease(h))
+			return;
+	} else if(checkGrabRelease(h)) {
 		return;
+	}
 
 	if(checkRotate(h))
 		return;
@@ -37,12 +45,12 @@ void GestureTracker::checkGestures(vector<Hand>* h) {
 /**
  * Check for grab gesture
  */
-bool GestureTracker::checkGrabRelease(vector<Hand>* h) {
+bool GestureTracker::checkGrabRelease(HandHistory* h) {
 	//need at least 3 hands confirming the gesture
 	int handsToTrack = 3;
 	int min_feature = 1;
 
-	float speedTolerance = 5.0f;
+	float speedTolerance = setting->gesture_min_speed; //pixels per second
 	float stdDevScaleFactor = 1.1f; //expected minimum change in size of std dev
 
 	float grabVectorTolerance = 0.8f;
@@ -55,10 +63,10 @@ bool GestureTracker::checkGrabRelease(vector<Hand>* h) {
 	float releasePercentTolerance = 0.5f;
 
 	for(int i = 0; i < handsToTrack; i++) {
-		if(!h->at(previousIndex(i)).isPresent()) {
+		if(!h->previous(i).isPresent()) {
 			return false;
 		}
-		if(h->at(previousIndex(i)).getNumOfFeatures() < min_feature) {
+		if(h->previous(i).getNumOfFeatures() < min_feature) {
 			return false;
 		}
 	}
@@ -72,26 +80,25 @@ bool GestureTracker::checkGrabRelease(vector<Hand>* h) {
 
 	for(int i=0; i<handsToTrack; i++) {
 
-		Point2f center = h->at(previousIndex(i)).getFeatureMean();
+		Point2f center = h->previous(i).getFeatureMean();
 
-		vector<Point2f> features = h->at(previousIndex(i)).getFeatures();
-		vector<Point2f> featVectors = h->at(previousIndex(i)).getVectors();
+		const HandFeatures& features = h->previous(i).getFeatures();
 
-		totalFeatures += features.size();
+		totalFeatures += features.count;
 
-		for(int j=0; j<features.size(); j++) {
+		for(int j=0; j<features.count; j++) {
 
 			//check if features are not diverging, indicating no grab
-			if( h->at(previousIndex(i)).getFeatureStdDev() > h->at(previousIndex(i+1)).getFeatureStdDev() * stdDevScaleFactor ) {
+			if( h->previous(i).getFeatureStdDev() > h->previous(i+1).getFeatureStdDev() * stdDevScaleFactor ) {
 				grab = false;
 			}
 			//check if features are not converging, indicating no release
-			if( h->at(previousIndex(i)).getFeatureStdDev() * stdDevScaleFactor < h->at(previousIndex(i+1)).getFeatureStdDev() ) {
+			if( h->previous(i).getFeatureStdDev() * stdDevScaleFactor < h->previous(i+1).getFeatureStdDev() ) {
 				release = false;
 			}
 
-			Point2f toCenter = (center - features[j]);
-			Point2f direction = featVectors[j];
+			Point2f toCenter = (center - features.position(j));
+			Point2f direction = features.vector(j);
 
 			float magnitude = sqrt(direction.x*direction.x + direction.y*direction.y);
 
@@ -131,18 +138,52 @@ bool GestureTracker::checkGrabRelease(vector<Hand>* h) {
 		release = false;
 
 	if(grab) {
-		verbosePrint("hand#: " + boost::lexical_cast<string>(h->at(index()).getHandNumber()) + " >>GRAB<<");
+		verbosePrint("hand#: " + boost::lexical_cast<string>(h->current().getHandNumber()) + " >>GRAB<<");
 		verbosePrint("grab %: " + boost::lexical_cast<string>(movingToCenter / (float) totalFeatures));
 		verbosePrint("Sum Gesture Features: " + boost::lexical_cast<string>(totalFeatures) + "\n");
-		h->at(index()).setGesture(GESTURE_GRAB);
+		h->current().setGesture(GESTURE_GRAB);
 		return true;
 	}
 
 	if(release) {
-		verbosePrint("hand#: " + boost::lexical_cast<string>(h->at(index()).getHandNumber()) + " >>RELEASE<<");
+		verbosePrint("hand#: " + boost::lexical_cast<string>(h->current().getHandNumber()) + " >>RELEASE<<");
 		verbosePrint("release %: " + boost::lexical_cast<string>(movingFromCenter / (float) totalFeatures));
 		verbosePrint("Sum Gesture Features: " + boost::lexical_cast<string>(totalFeatures) + "\n");
-		h->at(index()).setGesture(GESTURE_RELEASE);
+		h->current().setGesture(GESTURE_RELEASE);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Check for grab and release with the dense flow over the hand. A closing hand makes the
+ * flow converge (negative divergence) and an opening hand makes it diverge
+ */
+bool GestureTracker::checkFlowGrabRelease(HandHistory* h) {
+	//need at least 3 hands confirming the gesture
+	int handsToTrack = 3;
+
+	float divergence = 0;
+	for(int i = 0; i < handsToTrack; i++) {
+		if(!h->previous(i).isPresent() || !h->previous(i).hasFlow()) {
+			return false;
+		}
+		divergence += h->previous(i).getFlowDivergence();
+	}
+	divergence /= handsToTrack;
+
+	if(divergence < -setting->dense_flow_divergence) {
+		verbosePrint("hand#: " + boost::lexical_cast<string>(h->current().getHandNumber()) + " >>GRAB<<");
+		verbosePrint("flow divergence: " + boost::lexical_cast<string>(divergence) + "\n");
+		h->current().setGesture(GESTURE_GRAB);
+		return true;
+	}
+
+	if(divergence > setting->dense_flow_divergence) {
+		verbosePrint("hand#: " + boost::lexical_cast<string>(h->current().getHandNumber()) + " >>RELEASE<<");
+		verbosePrint("flow divergence: " + boost::lexical_cast<string>(divergence) + "\n");
+		h->current().setGesture(GESTURE_RELEASE);
 		return true;
 	}
 
@@ -152,30 +193,30 @@ bool GestureTracker::checkGrabRelease(vector<Hand>* h) {
 /**
  * Check rotate gesture
  */
-bool GestureTracker::checkRotate(vector<Hand>* h) {
+bool GestureTracker::checkRotate(HandHistory* h) {
 	//need at least 5 hands confirming the gesture
 //	int min_feature = 10;
 //	static float rot_tolerance = 30;
 //	static float area_tolerance = 1000;
 
-//	if(h->at(index()).isPresent() && h->at(previousIndex(1)).isPresent() && h->at(previousIndex(2)).isPresent() ) {
-//		if(h->at(index()).getNumOfFeatures() > min_feature &&
-//				(h->at(previousIndex(1)).getNumOfFeatures() > min_feature) &&
-//				(h->at(previousIndex(2)).getNumOfFeatures() > min_feature) &&
-//				(h->at(previousIndex(3)).getNumOfFeatures() > min_feature) &&
-//				(h->at(previousIndex(4)).getNumOfFeatures() > min_feature)) {
+//	if(h->current().isPresent() && h->previous(1).isPresent() && h->previous(2).isPresent() ) {
+//		if(h->current().getNumOfFeatures() > min_feature &&
+//				(h->previous(1).getNumOfFeatures() > min_feature) &&
+//				(h->previous(2).getNumOfFeatures() > min_feature) &&
+//				(h->previous(3).getNumOfFeatures() > min_feature) &&
+//				(h->previous(4).getNumOfFeatures() > min_feature)) {
 //
-//			float angle0 = h->at(index()).getAngle();
-//			float angle1 = h->at(previousIndex(1)).getAngle();
-//			float angle2 = h->at(previousIndex(2)).getAngle();
-//			float angle3 = h->at(previousIndex(3)).getAngle();
-//			float angle4 = h->at(previousIndex(4)).getAngle();
+//			float angle0 = h->current().getAngle();
+//			float angle1 = h->previous(1).getAngle();
+//			float angle2 = h->previous(2).getAngle();
+//			float angle3 = h->previous(3).getAngle();
+//			float angle4 = h->previous(4).getAngle();
 //
-//			float area0 = h->at(index()).getMinRect().size.area();
-//			float area1 = h->at(previousIndex(1)).getMinRect().size.area();
-//			float area2 = h->at(previousIndex(2)).getMinRect().size.area();
-//			float area3 = h->at(previousIndex(3)).getMinRect().size.area();
-//			float area4 = h->at(previousIndex(4)).getMinRect().size.area();
+//			float area0 = h->current().getMinRect().size.area();
+//			float area1 = h->previous(1).getMinRect().size.area();
+//			float area2 = h->previous(2).getMinRect().size.area();
+//			float area3 = h->previous(3).getMinRect().size.area();
+//			float area4 = h->previous(4).getMinRect().size.area();
 //
 ////			verbosePrint(boost::lexical_cast<std::string>(fabs(angle0 - angle4)));
 ////
@@ -193,14 +234,14 @@ bool GestureTracker::checkRotate(vector<Hand>* h) {
 //				if(angle0 > angle1 && angle1 > angle2 && angle2 > angle3 && angle3 > angle4 &&
 //						fabs(angle0 - angle4) > rot_tolerance) {
 //
-//					verbosePrint("hand#: " + boost::lexical_cast<string>(h->at(index()).getHandNumber()) +
+//					verbosePrint("hand#: " + boost::lexical_cast<string>(h->current().getHandNumber()) +
 //												" >>ROTATE<< clockwise");
 //					return true;
 //
 //				} else if(angle0 < angle1 && angle1 < angle2 && angle2 < angle3 && angle3 < angle4 &&
 //						fabs(angle0 - angle4) > rot_tolerance) {
 //
-//					verbosePrint("hand#: " + boost::lexical_cast<string>(h->at(index()).getHandNumber()) +
+//					verbosePrint("hand#: " + boost::lexical_cast<string>(h->current().getHandNumber()) +
 //							" >>ROTATE<< counter-clockwise");
 //					return true;
 //				}
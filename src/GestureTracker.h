@@ -22,17 +22,18 @@
 #ifndef GESTURETRACKER_H_
 #define GESTURETRACKER_H_
 
-#include "Hand.h"
+#include "HandHistory.h"
 #include <boost/lexical_cast.hpp>
 
 class GestureTracker {
 
 public:
-	static void checkGestures(vector<Hand>* h);
+	static void checkGestures(HandHistory* h);
 
 private:
-	static bool checkGrabRelease(vector<Hand>* h);
-	static bool checkRotate(vector<Hand>* h);
+	static bool checkGrabRelease(HandHistory* h);
+	static bool checkFlowGrabRelease(HandHistory* h);
+	static bool checkRotate(HandHistory* h);
 };
 
 #endif /* GESTURETRACKER_H_ */
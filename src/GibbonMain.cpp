@@ -26,59 +26,110 @@
 #include <ctime>
 #include <unistd.h>
 #include <sys/time.h>
+#include <boost/algorithm/string/predicate.hpp>
 
 #include "GibbonMain.h"
 #include "GestureTracker.h"
 #include "Setting.h"
 #include "CameraPGR.h"
+#include "VideoFileProvider.h"
+#include "SyntheticProvider.h"
+#include "RawFileProvider.h"
+#include "RawRecorder.h"
+#include "AsyncVideoWriter.h"
+#include "FramePairing.h"
+#include "SharpnessEngine.h"
+#include "WorkerPool.h"
+#include "BandScheduler.h"
+#include "BlobExtractor.h"
+#include "FeatureTracker.h"
+#include "HandFlow.h"
+#include "DepthSampler.h"
+#include "Profiler.h"
 #include "Log.h"
 #include "Hand.h"
+#include "HandHistory.h"
 #include "Message.h"
 #include "ImageUtils.h"
+#include "Undistortion.h"
 
 using namespace std;
 using namespace cv;
 
 /** OpenCV variables **/
 CvPoint mouseLocation;
-VideoWriter sourceWriter;
-VideoWriter resultWriter;
+AsyncVideoWriter sourceWriter; //encodes the camera frames on its own thread
+AsyncVideoWriter resultWriter; //encodes the annotated results on its own thread
+RawRecorder rawRecorder; //used instead of sourceWriter when source-recording-path ends in .gbraw
 
 /** Hand tracking structures [temporal tracking window] **/
 const uint hand_window_size = 12; //Number of frames to keep track of hand. Minimum of two is needed
-vector<Hand> handOne(hand_window_size, Hand(LEFT_HAND)); //circular: see index() function
-vector<Hand> handTwo(hand_window_size, Hand(RIGHT_HAND)); //circular: see index() function
+HandHistory handOne(LEFT_HAND, hand_window_size); //circular: advanced once per frame at the end of the main loop
+HandHistory handTwo(RIGHT_HAND, hand_window_size);
 
 /** goodFeaturesToTrack structure and settings **/
-vector<Point2f> previousCorners;
+FeatureTracker featureTracker; //features followed across frames, see findGoodFeatures()
+vector<Point2f> previousCorners; //previous position of each track of featureTracker
 bool noPreviousCorners = true;
-vector<Point2f> currentCorners; //Centre point of feature or corner rectangles
+vector<Point2f> currentCorners; //Centre point of feature or corner rectangles, one per track of featureTracker
 vector<float> featureDepth; //depth of current corners as calculated by featureDepthExtract function
-vector<uchar> flowStatus; //set to 1 if the flow for the corresponding features has been found, 0 otherwise
-vector<float> flowCount; //number of times the flow of this feature has been detected
+DepthSampler depthSampler; //window means of the touch image for featureDepthExtract
 //vector<uchar> leftRightStatus; // 0=None, 1=Left, 2=Right
-vector<float> flowError;
 //TermCriteria termCriteria = TermCriteria( CV_TERMCRIT_ITER | CV_TERMCRIT_EPS, 20, 0.3 );
 TermCriteria termCriteria = TermCriteria( CV_TERMCRIT_NUMBER | CV_TERMCRIT_EPS, 10, 0.3);
-double derivLambda = 0; //proportion for impact of "image intensity" as opposed to "derivatives"
-int maxCorners = 5;
+int maxCorners = 5; //features tracked per hand
 double qualityLevel = 0.01;//0.01;
 double minDistance = 10;
 int blockSize = 26;
 bool useHarrisDetector = false; //its either harris or cornerMinEigenVal
 
+/** touch image is only computed around the hands found by findHands() **/
+SharpnessEngine sharpness;
+vector<BlobDescriptor> blobDescriptors; //one per contour passed to findHands(), reused every frame
+vector<Rect> handRegions; //bounding rectangles of the hands in frame (distorted) coordinates
+
+/** optional dense flow over the hands, used for grab and release instead of the features **/
+HandFlow handFlow;
+Rect handFlowRegions[2]; //frame (distorted) bounds of hand one and hand two, empty when absent
+
+/** features are assigned to hands by reading one pixel of the hand label image **/
+Mat handLabels; //0 = no hand, 1 = hand one, 2 = hand two, in the coordinates of the hand contours
+vector<Rect> labeledRegions; //parts of handLabels written by the last rasterizeHands()
+
+/** only blobs large enough to be a hand have their contours traced **/
+BlobExtractor blobExtractor;
+
+/** the image stages of each frame run in bands on these threads **/
+WorkerPool workers;
+BandScheduler bandScheduler;
+
 CameraPGR pgrCamera;
 CameraPGR pgrObsCam1; //external camera for observing user
+const uint observer_history_size = 8; //observer frames kept to pair with tracker frames
+FramePairing observerPairing(observer_history_size); //matches each tracker frame with the observer frame nearest in time
+VideoFileProvider videoProvider; //recorded input used when there is no pgr camera
+SyntheticProvider syntheticProvider; //generated input used when there is no pgr camera and synthetic-input is set
+RawFileProvider rawProvider; //raw recording used when input-video-path ends in .gbraw
+ImageProvider* inputProvider = &videoProvider; //input used when there is no pgr camera
+Profiler profiler; //stage timings, only collected in benchmark mode
+framePolicy cameraFramePolicy = FRAME_POLICY_LATEST; //how processing consumes frames from the camera capture thread
+Undistortion* pointUndistortion = NULL; //only set in "points" undistortion mode, see CameraPGR::getPointUndistortion()
 
 Message* message; //used by updateMessage() and inside the main loop
 FileStorage logFile;
 ofstream logFile2; //second log file is a CSV file with values from potential models
 Mat logMatrixOne; //matrix containing data to log at each frame for hand one. cols = 24 + 6 * maxCorners rows = hand_window_size
 Mat logMatrixTwo; //log matrix for hand two
+int logRowOne = 0; //row of logMatrixOne written next, the log matrices are circular
+int logRowTwo = 0;
 
 bool wiz_grab = false;
 bool wiz_release = false;
 int frameCount = 0;
+double frameTimestamp = 0; //capture time of the frame being processed
+double previousFrameTimestamp = 0; //capture time of the frame processed before it, 0 for none
+double pipelineLatency = 0; //running mean of the time from capture to output, 0 when timestamps come from a recording
+const float motion_draw_interval = 1 / 30.0f; //motion vectors in pixels per second are drawn as the motion over this many seconds
 int fps = 0;
 int record_number = 0; //used for logging. Incremented after each record
 int log_num_cols = 24 + 6 * maxCorners; //number of columns in the log matrices
@@ -90,6 +141,9 @@ int main(int argc, char* argv[]) {
 		cout << "Error in loading options. Exiting the program." << endl;
 		return -1;
 	}
+	if(setting->self_test) {
+		return runSelfTests() ? 0 : 1;
+	}
 	verbosePrint("Starting ... ");
 
 	if(!setting->is_daemon) {
@@ -116,6 +170,18 @@ int main(int argc, char* argv[]) {
 	return 0;
 }
 
+/**
+ * Check every image kernel that replaces an OpenCV function against that function.
+ * Returns false if any of them differs.
+ */
+bool runSelfTests() {
+	bool passed = SharpnessKernel::selfTest(cout, false);
+	passed = binaryMajorityFilterSelfTest(cout) && passed;
+	passed = BlobExtractor::selfTest(cout) && passed;
+	passed = DepthSampler::selfTest(cout) && passed;
+	return passed;
+}
+
 /**
  * Initialize global variables
  */
@@ -123,8 +189,8 @@ void init() {
     logFile = FileStorage( setting->participant_number + "_log.yml", FileStorage::WRITE );
     string log2name = setting->participant_number + "_log.csv";
     logFile2.open ( log2name.c_str(), ios_base::app );
-    logMatrixOne = ( Mat_<float>( hand_window_size, log_num_cols ));
-    logMatrixTwo = ( Mat_<float>( hand_window_size, log_num_cols ));
+    logMatrixOne = Mat::zeros(hand_window_size, log_num_cols, CV_32FC1);
+    logMatrixTwo = Mat::zeros(hand_window_size, log_num_cols, CV_32FC1);
     setLog2Headers();
 	message = new Message();
 }
@@ -163,56 +229,66 @@ void setLog2Headers() {
     verbosePrint("LogFile2 Headers Written.");
 }
 
+/**
+ * Seconds from the capture of a frame to the display of its output, the time the
+ * position sent for a hand is predicted ahead
+ */
+double predictionHorizon() {
+	return pipelineLatency + setting->prediction_horizon;
+}
+
 /**
  * Check if there are any hands and add current hand gestures to global object
  * "message"
  */
 void updateMessage() {
 	int stepsBack = 1;
-	if(handOne.at(index()).isPresent() && (!handOne.at(previousIndex()).isPresent())) {
+	if(handOne.current().isPresent() && (!handOne.previous().isPresent())) {
 		//New hand!
-		if(handOne.at(previousIndex()).hasGesture()) {
+		handOne.getFilter().reset();
+		if(handOne.previous().hasGesture()) {
 			//go back 4 step to get closer to initial location gesture started at
-			handOne.at(previousIndex(stepsBack)).setGesture(handOne.at(previousIndex()).getGesture());
-			message->newHand(handOne.at(previousIndex(stepsBack)));
+			handOne.previous(stepsBack).setGesture(handOne.previous().getGesture());
+			message->newHand(handOne.previous(stepsBack).getState(handOne.previous(stepsBack).getTimestamp(), &handOne.getFilter(), predictionHorizon()));
 		} else {
-			message->newHand(handOne.at(index()));
+			message->newHand(handOne.current().getState(frameTimestamp, &handOne.getFilter(), predictionHorizon()));
 		}
-	} else if(handOne.at(index()).isPresent()) {
+	} else if(handOne.current().isPresent()) {
 		//Update existing hand
-		if(handOne.at(index()).hasGesture()) {
-			message->removeHand(handOne.at(index()));
-			handOne.at(index()).setPresent(false);
+		if(handOne.current().hasGesture()) {
+			message->removeHand(handOne.current().getState(frameTimestamp, NULL, 0));
+			handOne.current().setPresent(false);
 		} else {
-			message->updateHand(handOne.at(index()));
+			message->updateHand(handOne.current().getState(frameTimestamp, &handOne.getFilter(), predictionHorizon()));
 		}
-	} else if((!handOne.at(index()).isPresent()) && handOne.at(previousIndex()).isPresent()) {
+	} else if((!handOne.current().isPresent()) && handOne.previous().isPresent()) {
 		//ask for remove
-		message->removeHand(handOne.at(index()));
+		message->removeHand(handOne.current().getState(frameTimestamp, NULL, 0));
 	} else {
 		//Peace and quiet here. Nothing to do.
 	}
 
-	if(handTwo.at(index()).isPresent() && (!handTwo.at(previousIndex()).isPresent())) {
+	if(handTwo.current().isPresent() && (!handTwo.previous().isPresent())) {
 		//New hand!
-		if(handTwo.at(previousIndex()).hasGesture()) {
+		handTwo.getFilter().reset();
+		if(handTwo.previous().hasGesture()) {
 			//go back 4 step to get closer to initial location gesture started at
-			handTwo.at(previousIndex(stepsBack)).setGesture(handTwo.at(previousIndex()).getGesture());
-			message->newHand(handTwo.at(previousIndex(stepsBack)));
+			handTwo.previous(stepsBack).setGesture(handTwo.previous().getGesture());
+			message->newHand(handTwo.previous(stepsBack).getState(handTwo.previous(stepsBack).getTimestamp(), &handTwo.getFilter(), predictionHorizon()));
 		} else {
-			message->newHand(handTwo.at(index()));
+			message->newHand(handTwo.current().getState(frameTimestamp, &handTwo.getFilter(), predictionHorizon()));
 		}
-	} else if(handTwo.at(index()).isPresent()) {
+	} else if(handTwo.current().isPresent()) {
 		//Update existing hand
-		if(handTwo.at(index()).hasGesture()) {
-			message->removeHand(handTwo.at(index()));
-			handTwo.at(index()).setPresent(false);
+		if(handTwo.current().hasGesture()) {
+			message->removeHand(handTwo.current().getState(frameTimestamp, NULL, 0));
+			handTwo.current().setPresent(false);
 		} else {
-			message->updateHand(handTwo.at(index()));
+			message->updateHand(handTwo.current().getState(frameTimestamp, &handTwo.getFilter(), predictionHorizon()));
 		}
-	} else if((!handTwo.at(index()).isPresent()) && handTwo.at(previousIndex()).isPresent()){
+	} else if((!handTwo.current().isPresent()) && handTwo.previous().isPresent()){
 		//no hand, so ask for remove
-		message->removeHand(handTwo.at(index()));
+		message->removeHand(handTwo.current().getState(frameTimestamp, NULL, 0));
 	} else {
 		//nothing to do.
 	}
@@ -224,16 +300,16 @@ void updateMessage() {
  */
 void drawHandTrace(Mat img) {
 	//left hand
-	if(handOne.at(index()).isPresent()) {
-		ellipse(img, handOne[index()].getMinRect(), ORANGE, 2, 8);
+	if(handOne.current().isPresent()) {
+		ellipse(img, handOne.current().getMinRect(), ORANGE, 2, 8);
 		for(uint i = 0; i+1 < hand_window_size; i++) {
-			int current = previousIndex(i);
-			int previous = previousIndex(i + 1);
-			if(handOne.at(current).isPresent() && handOne.at(previous).isPresent()) {
+			Hand& current = handOne.previous(i);
+			Hand& previous = handOne.previous(i + 1);
+			if(current.isPresent() && previous.isPresent()) {
 				if(setting->left_grab_mode) {
-					line(img, handOne.at(previous).getMinRectCenter(), handOne.at(current).getMinRectCenter(), ORANGE, 5, 4, 0);
+					line(img, previous.getMinRectCenter(), current.getMinRectCenter(), ORANGE, 5, 4, 0);
 				} else {
-					line(img, handOne.at(previous).getMinRectCenter(), handOne.at(current).getMinRectCenter(), ORANGE, 2, 4, 0);
+					line(img, previous.getMinRectCenter(), current.getMinRectCenter(), ORANGE, 2, 4, 0);
 				}
             } else {
                 break;
@@ -242,17 +318,17 @@ void drawHandTrace(Mat img) {
 	}
 
 	//right hands
-	if(handTwo.at(index()).isPresent()) {
-		//polylines(img, handTwo[index()].getMinRect()., 4, 1, true, BLUE, 2, 8, 1);
-		ellipse(img, handTwo[index()].getMinRect(), BLUE, 2, 8);
+	if(handTwo.current().isPresent()) {
+		//polylines(img, handTwo.current().getMinRect()., 4, 1, true, BLUE, 2, 8, 1);
+		ellipse(img, handTwo.current().getMinRect(), BLUE, 2, 8);
 		for(uint i = 0; i+1 < hand_window_size; i++) {
-			int current = previousIndex(i);
-			int previous = previousIndex(i + 1);
-			if(handTwo.at(current).isPresent() && handTwo.at(previous).isPresent()) {
+			Hand& current = handTwo.previous(i);
+			Hand& previous = handTwo.previous(i + 1);
+			if(current.isPresent() && previous.isPresent()) {
 				if(setting->left_grab_mode) {
-					line(img, handTwo.at(previous).getMinRectCenter(), handTwo.at(current).getMinRectCenter(), BLUE, 5, 4, 0);
+					line(img, previous.getMinRectCenter(), current.getMinRectCenter(), BLUE, 5, 4, 0);
 				} else {
-					line(img, handTwo.at(previous).getMinRectCenter(), handTwo.at(current).getMinRectCenter(), BLUE, 2, 4, 0);
+					line(img, previous.getMinRectCenter(), current.getMinRectCenter(), BLUE, 2, 4, 0);
 				}
             } else {
                 break;
@@ -286,33 +362,37 @@ void processKey(char key) {
 			cvDestroyWindow("Tracked");
 			cvDestroyWindow("Binary");
 			cvDestroyWindow("Touch");
+			//calibration grabs images itself, so the capture thread has to stand aside
+			pgrCamera.stopCapture();
 			pgrCamera.calibrateUndistortionROI();
+			pointUndistortion = pgrCamera.getPointUndistortion();
+			pgrCamera.startCapture(setting->frame_ring_size, cameraFramePolicy);
 			printKeys();
 			break;
 		case 'j':
 			//simulate grab
-            if(handOne.at(index()).isPresent()) {
-                handOne.at(index()).setGesture(GESTURE_GRAB);
-                message->newHand(handOne.at(index()));
+            if(handOne.current().isPresent()) {
+                handOne.current().setGesture(GESTURE_GRAB);
+                message->newHand(handOne.current().getState(frameTimestamp, &handOne.getFilter(), predictionHorizon()));
                 saveRecord("GRAB", 1);
             }
-            if(handTwo.at(index()).isPresent()) {
-                handTwo.at(index()).setGesture(GESTURE_GRAB);
-                message->newHand(handTwo.at(index()));
+            if(handTwo.current().isPresent()) {
+                handTwo.current().setGesture(GESTURE_GRAB);
+                message->newHand(handTwo.current().getState(frameTimestamp, &handTwo.getFilter(), predictionHorizon()));
                 saveRecord("GRAB", 2);
             }
             verbosePrint("wizard says GRAB");
 			break;
 		case 'k':
 			//simulate release
-            if(handOne.at(index()).isPresent()) {
-                handOne.at(index()).setGesture(GESTURE_RELEASE);
-                message->newHand(handOne.at(index()));
+            if(handOne.current().isPresent()) {
+                handOne.current().setGesture(GESTURE_RELEASE);
+                message->newHand(handOne.current().getState(frameTimestamp, &handOne.getFilter(), predictionHorizon()));
                 saveRecord("RELEASE", 1);
             }
-            if(handTwo.at(index()).isPresent()) {
-                handTwo.at(index()).setGesture(GESTURE_RELEASE);
-                message->newHand(handTwo.at(index()));
+            if(handTwo.current().isPresent()) {
+                handTwo.current().setGesture(GESTURE_RELEASE);
+                message->newHand(handTwo.current().getState(frameTimestamp, &handTwo.getFilter(), predictionHorizon()));
                 saveRecord("RELEASE", 2);
             }
 			verbosePrint("wizard says RELEASE");
@@ -329,17 +409,33 @@ void processKey(char key) {
 }
 
 /**
- * find features in two frame and track them using optical flow.
- * result is stored in global data structure
+ * Follow the features of frame1 into frame2. New features are only detected, inside
+ * handMask and the region of the hand, when a present hand is left with fewer live
+ * features than min-features-per-hand, and then up to maxCorners for that hand.
+ * previousCorners and currentCorners receive the positions of the live tracks in frame coordinates.
  */
-void findGoodFeatures(Mat frame1, Mat frame2) {
-	if(frame1.cols == frame2.cols && frame1.rows == frame2.rows) { //ensure frames were not resized
-		previousCorners.clear();
-		goodFeaturesToTrack(frame1, previousCorners, maxCorners, qualityLevel, minDistance, Mat(), blockSize, useHarrisDetector);
-		//cornerSubPix(previousFrame, previousCorners, Size(10,10), Size(-1,-1), termCriteria);
-
-		int maxLevel = 1; // 0-based maximal pyramid level number. If 0, pyramids are not used (single level), if 1, two levels are used etc.
-		calcOpticalFlowPyrLK(frame1, frame2, previousCorners, currentCorners, flowStatus, flowError, Size(blockSize, blockSize), maxLevel, termCriteria, derivLambda, OPTFLOW_FARNEBACK_GAUSSIAN);
+void findGoodFeatures(Mat frame1, Mat frame2, Mat handMask) {
+	featureTracker.track(frame1, frame2, frameCount);
+	vector<FeatureTrack>& tracks = featureTracker.getTracks();
+
+	//hands as assigned in the previous frame, new tracks have no hand yet
+	int handFeatures[3] = {0, 0, 0};
+	for(uint i = 0; i < tracks.size(); i++) {
+		handFeatures[tracks[i].hand]++;
+	}
+	//each hand has its own budget, so one hand can never take all the features
+	Hand* hands[2] = {&handOne.current(), &handTwo.current()};
+	for(int i = 0; i < 2; i++) {
+		if(hands[i]->isPresent() && handFeatures[i + 1] < setting->min_features_per_hand) {
+			featureTracker.detect(frame2, handMask, handFlowRegions[i], maxCorners - handFeatures[i + 1]);
+		}
+	}
+
+	previousCorners.resize(tracks.size());
+	currentCorners.resize(tracks.size());
+	for(uint i = 0; i < tracks.size(); i++) {
+		previousCorners[i] = tracks[i].previous;
+		currentCorners[i] = tracks[i].position;
 	}
 }
 
@@ -349,12 +445,11 @@ void findGoodFeatures(Mat frame1, Mat frame2) {
  * a video file from predefined path
  */
 void start(){
+	bool recordedTimestamps = false; //true when frame timestamps come from a recording or the synthetic scene instead of this run
 	//Contour detection structures
 	vector<vector<cv::Point> > contours;
     //vector<Vec4i> hiearchy;
 
-	VideoCapture video(setting->input_video_path);
-
 	//Get external cameras
 	//VideoCapture externalCamOne(0); // open the first USB camera
 	//CvCapture *externalCamOne = 0;
@@ -370,33 +465,90 @@ void start(){
 
 	if(setting->pgr_obs_cam1_index >=0) {
         pgrObsCam1.init(setting->pgr_obs_cam1_index, false, true); //color
+		pgrObsCam1.setFrameRate(setting->obs_cam_fps);
+		pgrObsCam1.setScale(setting->obs_cam_scale);
+		//the observer captures at its own rate so its color conversion never slows down tracking
+		pgrObsCam1.startCapture(setting->frame_ring_size);
 	}
 
 	if(setting->pgr_cam_index >= 0) {
         pgrCamera.init(setting->pgr_cam_index, true, false); //monochrome
+		if(setting->frame_policy == "every") {
+			cameraFramePolicy = FRAME_POLICY_EVERY;
+		}
+		pointUndistortion = pgrCamera.getPointUndistortion();
+		pgrCamera.startCapture(setting->frame_ring_size, cameraFramePolicy);
+	} else if(setting->synthetic_input) {
+		syntheticProvider.init(setting->synthetic_seed, setting->synthetic_hands, Size(setting->synthetic_width, setting->synthetic_height),
+				setting->synthetic_blur, setting->synthetic_noise, setting->synthetic_fps);
+		verbosePrint("Synthetic input, seed = " + boost::lexical_cast<string>(setting->synthetic_seed));
+		inputProvider = &syntheticProvider;
+		//frames are stamped with their time in the scene, not with the time they were rendered
+		recordedTimestamps = true;
+		inputProvider->startCapture(setting->frame_ring_size);
+	} else if(boost::algorithm::ends_with(setting->input_video_path, ".gbraw")) {
+		if(!rawProvider.open(setting->input_video_path, setting->video_replay_mode == "fast")) {
+			cout << "Failed to open raw recording: " << setting->input_video_path << endl;
+			return;
+		}
+		verbosePrint("Raw recording path = " + setting->input_video_path);
+		//frames are read straight from the mapped file, a capture thread would only add a copy
+		inputProvider = &rawProvider;
+		recordedTimestamps = true;
 	} else {
-		video.set(CV_CAP_PROP_FPS, 30);
-		if(!video.isOpened()) { // check if we succeeded
+		if(!videoProvider.open(setting->input_video_path, setting->video_replay_mode == "fast")) { // check if we succeeded
 			cout << "Failed to open video file: " << setting->input_video_path << endl;
 			return;
 		}
-		if (setting->verbose)  {
-			cout << "Video path = " << setting->input_video_path << endl;
-			cout << "Video fps = " << video.get(CV_CAP_PROP_FPS);
+		verbosePrint("Video path = " + setting->input_video_path);
+		inputProvider = &videoProvider;
+		//frames are stamped with their time in the recording, which runs ahead of this run when replayed fast
+		recordedTimestamps = setting->video_replay_mode == "fast";
+		//decode ahead of the tracker on the capture thread
+		inputProvider->startCapture(setting->frame_ring_size);
+	}
+	profiler.setEnabled(setting->benchmark_frames > 0);
+	if(maxCorners > max_hand_features) {
+		//a hand keeps at most max_hand_features features, more tracks would be dropped silently
+		cout << "Warning: " << maxCorners << " features per hand requested, only " << max_hand_features << " are tracked" << endl;
+		maxCorners = max_hand_features;
+	}
+	featureTracker.setDetection(qualityLevel, minDistance, blockSize);
+	featureTracker.setFlow(Size(setting->lk_window_size, setting->lk_window_size), setting->lk_max_level, termCriteria, setting->lk_min_eig_threshold);
+	handOne.getFilter().setParameters(setting->filter_min_cutoff, setting->filter_beta, setting->filter_derivative_cutoff);
+	handTwo.getFilter().setParameters(setting->filter_min_cutoff, setting->filter_beta, setting->filter_derivative_cutoff);
+	workers.start(setting->worker_threads);
+	bandScheduler.setWorkerPool(&workers);
+	sharpness.setWorkerPool(&workers);
+	handFlow.setWorkerPool(&workers);
+	handFlow.setParameters(setting->dense_flow_downscale, setting->dense_flow_padding);
+	verbosePrint("Worker threads = " + boost::lexical_cast<string>(workers.getThreadCount()));
+	sharpness.useFusedKernel(setting->sharpness_kernel != "opencv");
+	if(setting->sharpness_kernel != "opencv") {
+		//never track with a fused kernel that disagrees with OpenCV on this machine
+		std::ostringstream report;
+		if(!SharpnessKernel::selfTest(report, profiler.isEnabled())) {
+			cout << report.str() << "Error: fused sharpness kernel failed its self test, using opencv instead" << endl;
+			sharpness.useFusedKernel(false);
+		} else if(profiler.isEnabled()) {
+			cout << report.str();
 		}
 	}
+	verbosePrint(string("Sharpness kernel = ") + sharpness.getKernelName());
 
 	//Preparing for main video loop
 	Mat previousFrame;
 	Mat currentFrame;
 	Mat trackingResults;
 	Mat binaryImg; //binary image for finding contours of the hand
-	Mat tmpColor;
 	Mat touchImage;
 	Mat previousTouchImage;
     Mat obs1Frame;
+	unsigned long obs1Sequence = 0; //sequence number of the observer frame shown in displayResults
+	bool obs1Refreshed = false; //true when obs1Frame has to be copied into displayResults
 	Mat tmpEigenBGR; //temporary color version of eigen value (touch) image to display
 	Mat displayResults;
+	Mat undistortedFrame; //display copy of the current frame in "points" undistortion mode
 
     Mat roiImgResult_topLeft;
     Mat roiImgResult_topRight;
@@ -405,7 +557,6 @@ void start(){
 	//Mat watershed_markers = cvCreateImage( setting->imageSize, IPL_DEPTH_32S, 1 );
 	//Mat watershed_image;
 
-	flowCount = vector<float>(maxCorners);
 	char key = 'a';
 	timeval first_time, second_time; //for fps calculation
 	time_t rawtime; //time to display
@@ -416,31 +567,61 @@ void start(){
     string time_str;
 	gettimeofday(&first_time, 0);
     fps = 0;
+	double benchmarkStart = 0; //capture time when the first frame was received in benchmark mode
 	while(key != 'q') {
-		if(setting->pgr_obs_cam1_index >=0){
-            //obs1Frame.release();
-            obs1Frame = pgrObsCam1.grabImage();
-		}
-
+		profiler.begin("frame");
 		if(setting->pgr_cam_index >= 0){
-            //currentFrame.release();
-			currentFrame = pgrCamera.grabImage();
+			profiler.begin("wait");
+			const Frame* frame = pgrCamera.nextFrame(cameraFramePolicy);
+			profiler.end("wait");
+			if(frame == NULL) {
+				cout << "Camera capture has stopped" << endl;
+				break;
+			}
+			currentFrame = frame->image;
+			frameTimestamp = frame->timestamp;
 
-			if(setting->save_input_video) {
+			if(setting->save_input_video && boost::algorithm::ends_with(setting->source_recording_path, ".gbraw")) {
+				//raw frames are copied as they are, no conversion or encoding on this thread
+				if(!rawRecorder.isOpen()) {
+					rawRecorder.open(setting->source_recording_path, currentFrame.size(), currentFrame.type(), setting->raw_recording_frames);
+				}
+				rawRecorder.append(currentFrame, frame->sequence, frame->timestamp);
+			} else if(setting->save_input_video) {
+				//conversion to color and encoding happen on the writer thread
 				if (sourceWriter.isOpened()) {
-					cvtColor(currentFrame, tmpColor, CV_GRAY2RGB);
-					sourceWriter << tmpColor;
+					sourceWriter.write(currentFrame);
 				} else {
-					sourceWriter = VideoWriter(setting->source_recording_path, CV_FOURCC('D', 'I', 'V', '5'), fps,
-                            Size(setting->imageSizeX,setting->imageSizeY));
+					sourceWriter.open(setting->source_recording_path, CV_FOURCC('D', 'I', 'V', '5'), fps,
+                            Size(setting->imageSizeX,setting->imageSizeY), setting->recording_queue_size,
+                            parseOverflowPolicy(setting->recording_overflow_policy));
                 }
 			}
 		} else{
-			//This is a video file source, no need to save
-			video >> currentFrame;
+			//This is a video file or synthetic source, no need to save. Every frame is processed
+			profiler.begin("wait");
+			const Frame* frame = inputProvider->nextFrame(FRAME_POLICY_EVERY);
+			profiler.end("wait");
+			if(frame == NULL) {
+				verbosePrint("End of input");
+				break;
+			}
+			currentFrame = frame->image;
+			frameTimestamp = frame->timestamp;
+		}
+		if(frameCount == 0) {
+			benchmarkStart = captureTime();
+		}
 
-			cvtColor(currentFrame, tmpColor, CV_RGB2GRAY);
-			currentFrame = tmpColor;
+		if(setting->pgr_obs_cam1_index >=0){
+			//take whatever the observer has captured so far and pair without waiting for it
+			observerPairing.collect(pgrObsCam1);
+			const Frame* observerFrame = observerPairing.nearest(frameTimestamp);
+			if(observerFrame != NULL && (obs1Frame.empty() || observerFrame->sequence != obs1Sequence)) {
+				obs1Frame = observerFrame->image;
+				obs1Sequence = observerFrame->sequence;
+				obs1Refreshed = true;
+			}
 		}
 
 		message->init();
@@ -468,24 +649,22 @@ void start(){
 		 * Prepare the binary image for tracking hands as the two largest blobs in the scene
          */
         //binaryImg.release();
-		binaryImg = currentFrame.clone();
-		threshold(currentFrame, binaryImg, setting->lower_threshold, setting->upper_threshold, THRESH_BINARY);
-
 		if(setting->capture_snapshot) {
-			imwrite(setting->snapshot_path + ctime(&rawtime) + "_binary.png", binaryImg);
+			Mat thresholdImg;
+			threshold(currentFrame, thresholdImg, setting->lower_threshold, setting->upper_threshold, THRESH_BINARY);
+			imwrite(setting->snapshot_path + ctime(&rawtime) + "_binary.png", thresholdImg);
 		}
 
-		//clean up the current frame from noise using median blur filter
-		medianBlur(binaryImg, binaryImg, setting->median_blur_factor);
+		//threshold and clean up the current frame from noise using median blur filter, in bands on the workers
+		profiler.begin("threshold+median");
+		bandScheduler.thresholdMedian(currentFrame, binaryImg, setting->lower_threshold, setting->upper_threshold,
+				setting->median_blur_factor);
+		profiler.end("threshold+median");
 		if(setting->capture_snapshot) {
 			imwrite(setting->snapshot_path + ctime(&rawtime) + "_median.png", binaryImg);
 		}
 
 		//adaptiveThreshold(binaryImg, binaryImg, 255, ADAPTIVE_THRESH_MEAN_C, THRESH_BINARY, 3, 10); //adaptive thresholding not works so well here
-        //touchImage.release();
-		touchImage = Mat(currentFrame.size(), CV_32FC1);
-		sharpnessImage(currentFrame, touchImage);
-		touchImage.convertTo(touchImage, CV_8UC1, 50, 0);
 
 		if(!setting->is_daemon) {
 			//imshow("Binary", binaryImg);
@@ -500,11 +679,21 @@ void start(){
 		//findContours(binaryImg, contours, hiearchy, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_TC89_L1);
 		//findContours(binaryImg, contours, hiearchy,  RETR_TREE, CHAIN_APPROX_SIMPLE);
 		//findContours(binaryImg, contours, hiearchy,  RETR_EXTERNAL|RETR_CCOMP, CHAIN_APPROX_NONE);
-		findContours( binaryImg, contours, RETR_EXTERNAL, CV_CHAIN_APPROX_NONE );
+		profiler.begin("contours");
+		//label all the blobs but only trace the ones that can pass the radius threshold in findHands()
+		blobExtractor.extract(binaryImg);
+		blobExtractor.traceLargeBlobs(setting->radius_threshold, contours);
+		profiler.end("contours");
 
 		//Canny(previousFrame, previousFrame, 0, 30, 3);
 		if(!setting->is_daemon) {
-			cvtColor(currentFrame, trackingResults, CV_GRAY2BGR);
+			if(pointUndistortion != NULL) {
+				//tracking results are in undistorted coordinates, so show them on an undistorted frame
+				pointUndistortion->undistortROIImage(currentFrame, undistortedFrame);
+				bandScheduler.grayToColor(undistortedFrame, trackingResults);
+			} else {
+				bandScheduler.grayToColor(currentFrame, trackingResults);
+			}
 
 			if (contours.size() > 0) {
 //				int index = 0;
@@ -519,12 +708,42 @@ void start(){
 		//watershed(watershed_image, touchImage);
 		//imshow("Watershed", touchImage);
 
+		profiler.begin("hands");
 		findHands(contours);
+		rasterizeHands(contours, currentFrame.size());
         setFeatureMats();
+		profiler.end("hands");
+
+		//touch image is only sampled inside the hands, so only compute it there
+		profiler.begin("sharpness");
+		touchImage = sharpness.compute(currentFrame, handRegions);
+		profiler.end("sharpness");
+		if(setting->dense_flow) {
+			//camera frames are not kept, so this runs every frame to keep the previous hand images
+			profiler.begin("dense flow");
+			handFlow.compute(currentFrame, binaryImg, handFlowRegions);
+			profiler.end("dense flow");
+			//flow statistics are per frame, hands keep them per second
+			double interval = frameTimestamp - previousFrameTimestamp;
+			if(previousFrameTimestamp > 0 && interval > 0) {
+				if(handOne.current().isPresent() && handFlow.getStats(0).valid) {
+					handOne.current().setFlow(handFlow.getStats(0).divergence / interval, handFlow.getStats(0).curl / interval);
+				}
+				if(handTwo.current().isPresent() && handFlow.getStats(1).valid) {
+					handTwo.current().setFlow(handFlow.getStats(1).divergence / interval, handFlow.getStats(1).curl / interval);
+				}
+			}
+		}
 		if(numberOfHands() > 0) {
+			profiler.begin("features");
 			//findGoodFeatures(previousFrame, currentFrame);
-			findGoodFeatures(previousTouchImage, touchImage);
+			findGoodFeatures(previousTouchImage, touchImage, binaryImg);
 			featureDepthExtract(touchImage);
+			if(pointUndistortion != NULL) {
+				//depth is sampled at the distorted positions, hands are in undistorted coordinates
+				pointUndistortion->undistortROIPoints(previousCorners);
+				pointUndistortion->undistortROIPoints(currentCorners);
+			}
 			assignFeaturesToHands();
 			meanAndStdDevExtract();
 			if(setting->wiz_of_oz) {
@@ -533,6 +752,7 @@ void start(){
 				GestureTracker::checkGestures(&handOne);
 				GestureTracker::checkGestures(&handTwo);
 			}
+			profiler.end("features");
 			if(!setting->is_daemon) {
 				//only draw things if there are going to be displayed
 				drawHandTrace(trackingResults);
@@ -540,7 +760,12 @@ void start(){
 				drawMeanAndStdDev(trackingResults);
 			}
 		} else {
-			//TODO: is any cleanup necessary here?
+			//features cannot be followed through frames without hands
+			featureTracker.clear();
+		}
+		if(!recordedTimestamps) {
+			//averaged so the prediction horizon does not jitter from frame to frame
+			pipelineLatency += 0.1 * (captureTime() - frameTimestamp - pipelineLatency);
 		}
 		updateMessage();
 
@@ -558,13 +783,29 @@ void start(){
 		if(!setting->is_daemon) {
 			//Combine images to display
 			cvtColor(touchImage, tmpEigenBGR, CV_GRAY2BGR);
-            //displayResults.release();
-            displayResults = Mat(trackingResults.rows + tmpEigenBGR.rows, trackingResults.cols + trackingResults.cols, CV_8UC3, Scalar(30,10,10));
+            //displayResults is kept between frames so the observer part only changes when the observer does
+            Size displaySize(trackingResults.cols + trackingResults.cols, trackingResults.rows + tmpEigenBGR.rows);
+            if(displayResults.size() != displaySize) {
+                displayResults.create(displaySize, CV_8UC3);
+                displayResults.setTo(Scalar(30,10,10));
+                obs1Refreshed = true;
+            } else {
+                //clear the text area
+                displayResults(Rect(0, trackingResults.rows, trackingResults.cols, tmpEigenBGR.rows)).setTo(Scalar(30,10,10));
+            }
             roiImgResult_topLeft = displayResults(Rect(0, 0, trackingResults.cols, trackingResults.rows)); //Image will be on the top left part
             roiImgResult_topRight = displayResults(Rect(trackingResults.cols, 0, trackingResults.cols, trackingResults.rows));
             roiImgResult_lowerRight = displayResults(Rect(trackingResults.cols, trackingResults.rows, tmpEigenBGR.cols, tmpEigenBGR.rows));
 			trackingResults.copyTo(roiImgResult_topLeft);
-            obs1Frame.copyTo(roiImgResult_topRight);
+            if(obs1Refreshed && !obs1Frame.empty()) {
+                if(obs1Frame.size() == roiImgResult_topRight.size()) {
+                    obs1Frame.copyTo(roiImgResult_topRight);
+                } else {
+                    //downscaled observer frames are scaled back up once per observer frame
+                    resize(obs1Frame, roiImgResult_topRight, roiImgResult_topRight.size());
+                }
+                obs1Refreshed = false;
+            }
 			tmpEigenBGR.copyTo(roiImgResult_lowerRight);
 
             //add fps info
@@ -596,7 +837,19 @@ void start(){
 			fps_str << "FPS = [" << fps << "]";
 			first_time = second_time;
 		}
-		if(frameCount % 1000 == 0) verbosePrint(fps_str.str()); //report fps every 1000 frame on the terminal
+		if(frameCount % 1000 == 0) {
+			//report fps and lost camera frames every 1000 frame on the terminal
+			verbosePrint(fps_str.str());
+			if(setting->pgr_cam_index >= 0) {
+				verbosePrint("Camera frames dropped = " + boost::lexical_cast<string>(pgrCamera.getDroppedFrames())
+						+ ", skipped = " + boost::lexical_cast<string>(pgrCamera.getSkippedFrames())
+						+ ", buffer allocations = " + boost::lexical_cast<string>(pgrCamera.getAllocationCount()));
+			}
+			if(sourceWriter.isOpened() || resultWriter.isOpened()) {
+				verbosePrint("Recording frames dropped: source = " + boost::lexical_cast<string>(sourceWriter.getDroppedFrames())
+						+ ", result = " + boost::lexical_cast<string>(resultWriter.getDroppedFrames()));
+			}
+		}
 
 		if(!setting->is_daemon) {
             //add tuio info
@@ -617,11 +870,12 @@ void start(){
 
 			if(setting->save_output_video){
 				if (resultWriter.isOpened()) {
-					resultWriter << displayResults;
+					resultWriter.write(displayResults);
 					putText(displayResults, "Recording Results ... ", Point(300, trackingResults.rows + 30), FONT_HERSHEY_COMPLEX, 1, RED, 3, 8, false);
 				} else {
-                    resultWriter = VideoWriter(setting->result_recording_path + setting->participant_number + "_" + ctime(&rawtime) + ".avi", CV_FOURCC('D', 'X', '5', '0'), fps,
-							Size(displayResults.cols, displayResults.rows));
+                    resultWriter.open(setting->result_recording_path + setting->participant_number + "_" + ctime(&rawtime) + ".avi", CV_FOURCC('D', 'X', '5', '0'), fps,
+							Size(displayResults.cols, displayResults.rows), setting->recording_queue_size,
+							parseOverflowPolicy(setting->recording_overflow_policy));
 				}
 			}
 			if(setting->save_input_video){
@@ -634,14 +888,22 @@ void start(){
 		}
 
 		message->commit();
+		if(!recordedTimestamps) {
+			profiler.addSample("latency", captureTime() - frameTimestamp);
+		}
+		profiler.end("frame");
         //previousFrame.release();
 		previousFrame = currentFrame;
 
-		currentCorners = previousCorners;
-
         //previousTouchImage.release();
 		previousTouchImage = touchImage;
+		previousFrameTimestamp = frameTimestamp;
+		handOne.advance();
+		handTwo.advance();
 		frameCount++;
+		if(setting->benchmark_frames > 0 && frameCount >= setting->benchmark_frames) {
+			break;
+		}
 
         /*//release some memory before going to next frame
         trackingResults.release();
@@ -655,252 +917,217 @@ void start(){
         */
 	}
 
+	if(profiler.isEnabled() && frameCount > 0) {
+		double elapsed = captureTime() - benchmarkStart;
+		cout << "Benchmark: " << frameCount << " frames in " << elapsed << " s = " << frameCount / elapsed << " fps" << endl;
+		profiler.report(cout);
+		cout << "Feature detection ran on " << featureTracker.getDetectionCount() << " of " << frameCount << " frames, "
+				<< featureTracker.getPyramidCount() << " optical flow pyramids built" << endl;
+		if(workers.getThreadCount() > 1) {
+			reportParallelSpeedup(currentFrame);
+		}
+	}
+
 	//Clean up before leaving
+	inputProvider->stopCapture();
+	rawRecorder.close();
+	if(sourceWriter.isOpened() || resultWriter.isOpened()) {
+		verbosePrint("Recording frames written: source = " + boost::lexical_cast<string>(sourceWriter.getWrittenFrames())
+				+ " (" + boost::lexical_cast<string>(sourceWriter.getDroppedFrames()) + " dropped), result = "
+				+ boost::lexical_cast<string>(resultWriter.getWrittenFrames())
+				+ " (" + boost::lexical_cast<string>(resultWriter.getDroppedFrames()) + " dropped)");
+	}
+	//finish encoding what is still queued
+	sourceWriter.close();
+	resultWriter.close();
 	previousFrame.release();
 	currentFrame.release();
 	trackingResults.release();
-	tmpColor.release();
     logFile.release();
+	//the camera objects are global, static destruction releases the rest
 	if(setting->pgr_cam_index >= 0){
-		pgrCamera.~CameraPGR();
+		pgrCamera.close();
 	}
     if(setting->pgr_obs_cam1_index >=0){
-        pgrObsCam1.~CameraPGR();
+        pgrObsCam1.close();
     }
 }
 
 /**
  * Find two largest blobs which hopefully represent the two hands
  */
-void findHands(vector<vector<cv::Point> > contours) {
-
-	bool handOnePresent = handOne.at(previousIndex()).isPresent();
-	bool handTwoPresent = handTwo.at(previousIndex()).isPresent();
-	Point handOneCenter = handOne.at(previousIndex()).getMinCircleCenter();
-	Point handTwoCenter = handTwo.at(previousIndex()).getMinCircleCenter();
-
-	handOne[index()].clear();
-	handTwo[index()].clear();
-	Point2f tmpCenter, max1Center, max2Center;
-	float tmpRadius = 0, max1Radius = 0, max2Radius = 0;
-	int max1ContourIndex = 0, max2ContourIndex = 0;
+void findHands(vector<vector<cv::Point> >& contours) {
+
+	bool handOnePresent = handOne.previous().isPresent();
+	bool handTwoPresent = handTwo.previous().isPresent();
+	Point handOneCenter = handOne.previous().getMinCircleCenter();
+	Point handTwoCenter = handTwo.previous().getMinCircleCenter();
+
+	handOne.current().clear();
+	handTwo.current().clear();
+	handOne.current().setTimestamp(frameTimestamp);
+	handTwo.current().setTimestamp(frameTimestamp);
+	float max1Radius = 0, max2Radius = 0;
+	int max1Blob = 0, max2Blob = 0;
 	int contour_side_threshold = 50;
 
+	//describe every candidate once and keep the two with the largest enclosing circles
+	blobDescriptors.resize(contours.size());
 	for (uint i = 0; i < contours.size(); i++) {
-
-		Size2f tmpSize = minAreaRect(Mat(contours[i])).size;
-		float tmpSide = min(tmpSize.height, tmpSize.width);
+		BlobDescriptor& blob = blobDescriptors[i];
+		describeBlob(contours[i], i, blob);
+		float tmpSide = min(blob.minRect.size.height, blob.minRect.size.width);
 
 		if(tmpSide > contour_side_threshold) {
-
-			minEnclosingCircle(Mat(contours[i]), tmpCenter, tmpRadius);
-
-			if (tmpRadius > max1Radius) {
+			if (blob.circleRadius > max1Radius) {
 				if (max1Radius > max2Radius) {
 					max2Radius = max1Radius;
-					max2Center = max1Center;
-					max2ContourIndex = max1ContourIndex;
+					max2Blob = max1Blob;
 				}
-				max1Radius = tmpRadius;
-				max1Center = tmpCenter;
-				max1ContourIndex = i;
-			} else if (tmpRadius > max2Radius) {
+				max1Radius = blob.circleRadius;
+				max1Blob = i;
+			} else if (blob.circleRadius > max2Radius) {
 				//max1Radius is bigger than max2Radius
-				max2Radius = tmpRadius;
-				max2Center = tmpCenter;
-				max2ContourIndex = i;
+				max2Radius = blob.circleRadius;
+				max2Blob = i;
 			}
 		}
 	}
+	int handBlobs[2] = {max1Blob, max2Blob};
+	int handCount = 0;
+	if(max1Radius > setting->radius_threshold) {
+		handCount = max2Radius > setting->radius_threshold ? 2 : 1;
+	}
 
-	//Detect the two largest circles that represent hands, if they exist
-	if(max1Radius > setting->radius_threshold && max2Radius > setting->radius_threshold) {
-		//Two hands Present
-		if(!handOnePresent && !handTwoPresent) {
-			//default: max1 is hand one
-			handOne[index()].setMinCircleCenter(max1Center);
-			handOne[index()].setMinCircleRadius(max1Radius);
-			handOne[index()].setContour(contours[max1ContourIndex]);
-			handOne[index()].setMinRect(minAreaRect(Mat(contours[max1ContourIndex])));
-			handOne[index()].setPresent(true);
-			//and max2 is hand two
-			handTwo[index()].setMinCircleCenter(max2Center);
-			handTwo[index()].setMinCircleRadius(max2Radius);
-			handTwo[index()].setContour(contours[max2ContourIndex]);
-			handTwo[index()].setMinRect(minAreaRect(Mat(contours[max2ContourIndex])));
-			handTwo[index()].setPresent(true);
-		} else if(handOnePresent && !handTwoPresent) {
-			if(getDistance(handOneCenter, max1Center) < getDistance(handOneCenter, max2Center)) {
-				//max1 is on the left
-				handOne[index()].setMinCircleCenter(max1Center);
-				handOne[index()].setMinCircleRadius(max1Radius);
-				handOne[index()].setContour(contours[max1ContourIndex]);
-				handOne[index()].setMinRect(minAreaRect(Mat(contours[max1ContourIndex])));
-				handOne[index()].setPresent(true);
-				//and max2 is on the right
-				handTwo[index()].setMinCircleCenter(max2Center);
-				handTwo[index()].setMinCircleRadius(max2Radius);
-				handTwo[index()].setContour(contours[max2ContourIndex]);
-				handTwo[index()].setMinRect(minAreaRect(Mat(contours[max2ContourIndex])));
-				handTwo[index()].setPresent(true);
-			} else {
-				//max1 is on the right
-				handTwo[index()].setMinCircleCenter(max1Center);
-				handTwo[index()].setMinCircleRadius(max1Radius);
-				handTwo[index()].setContour(contours[max1ContourIndex]);
-				handTwo[index()].setMinRect(minAreaRect(Mat(contours[max1ContourIndex])));
-				handTwo[index()].setPresent(true);
-				//max2 is therefore on the left
-				handOne[index()].setMinCircleCenter(max2Center);
-				handOne[index()].setMinCircleRadius(max2Radius);
-				handOne[index()].setContour(contours[max2ContourIndex]);
-				handOne[index()].setMinRect(minAreaRect(Mat(contours[max2ContourIndex])));
-				handOne[index()].setPresent(true);
-			}
-		} else {
-			if(getDistance(handTwoCenter, max1Center) > getDistance(handTwoCenter, max2Center)) {
-				//max1 is on the left
-				handOne[index()].setMinCircleCenter(max1Center);
-				handOne[index()].setMinCircleRadius(max1Radius);
-				handOne[index()].setContour(contours[max1ContourIndex]);
-				handOne[index()].setMinRect(minAreaRect(Mat(contours[max1ContourIndex])));
-				handOne[index()].setPresent(true);
-				//and max2 is on the right
-				handTwo[index()].setMinCircleCenter(max2Center);
-				handTwo[index()].setMinCircleRadius(max2Radius);
-				handTwo[index()].setContour(contours[max2ContourIndex]);
-				handTwo[index()].setMinRect(minAreaRect(Mat(contours[max2ContourIndex])));
-				handTwo[index()].setPresent(true);
-			} else {
-				//max1 is on the right
-				handTwo[index()].setMinCircleCenter(max1Center);
-				handTwo[index()].setMinCircleRadius(max1Radius);
-				handTwo[index()].setContour(contours[max1ContourIndex]);
-				handTwo[index()].setMinRect(minAreaRect(Mat(contours[max1ContourIndex])));
-				handTwo[index()].setPresent(true);
-				//max2 is therefore on the left
-				handOne[index()].setMinCircleCenter(max2Center);
-				handOne[index()].setMinCircleRadius(max2Radius);
-				handOne[index()].setContour(contours[max2ContourIndex]);
-				handOne[index()].setMinRect(minAreaRect(Mat(contours[max2ContourIndex])));
-				handOne[index()].setPresent(true);
-			}
+	//touch image is computed on the frame as it is, so keep the regions in frame coordinates
+	handRegions.clear();
+	for(int i = 0; i < handCount; i++) {
+		handRegions.push_back(blobDescriptors[handBlobs[i]].bounds);
+	}
+
+	if(pointUndistortion != NULL) {
+		//hands are picked on the distorted image but described in undistorted coordinates
+		for(int i = 0; i < handCount; i++) {
+			pointUndistortion->undistortROIContour(contours[handBlobs[i]]);
+			describeBlob(contours[handBlobs[i]], handBlobs[i], blobDescriptors[handBlobs[i]]);
 		}
-	} else if(max1Radius > setting->radius_threshold ){
-		if(!handOnePresent && !handTwoPresent) {
-			handOne[index()].setMinCircleCenter(max1Center);
-			handOne[index()].setMinCircleRadius(max1Radius);
-			handOne[index()].setContour(contours[max1ContourIndex]);
-			handOne[index()].setMinRect(minAreaRect(Mat(contours[max1ContourIndex])));
-			handOne[index()].setPresent(true);
-		} else if(handOnePresent && !handTwoPresent) {
-			if(getDistance(handOneCenter, max1Center) < setting->radius_threshold*4) {
-				handOne[index()].setMinCircleCenter(max1Center);
-				handOne[index()].setMinCircleRadius(max1Radius);
-				handOne[index()].setContour(contours[max1ContourIndex]);
-				handOne[index()].setMinRect(minAreaRect(Mat(contours[max1ContourIndex])));
-				handOne[index()].setPresent(true);
-				//clear right hand
-				handTwo[index()].clear();
-			} else {
-				handTwo[index()].setMinCircleCenter(max1Center);
-				handTwo[index()].setMinCircleRadius(max1Radius);
-				handTwo[index()].setContour(contours[max1ContourIndex]);
-				handTwo[index()].setMinRect(minAreaRect(Mat(contours[max1ContourIndex])));
-				handTwo[index()].setPresent(true);
-				//clear right hand
-				handOne[index()].clear();
-			}
-		} else {
-			if(getDistance(handTwoCenter, max1Center) > setting->radius_threshold*4) {
-				handOne[index()].setMinCircleCenter(max1Center);
-				handOne[index()].setMinCircleRadius(max1Radius);
-				handOne[index()].setContour(contours[max1ContourIndex]);
-				handOne[index()].setMinRect(minAreaRect(Mat(contours[max1ContourIndex])));
-				handOne[index()].setPresent(true);
-				//clear right hand
-				handTwo[index()].clear();
-			} else {
-				handTwo[index()].setMinCircleCenter(max1Center);
-				handTwo[index()].setMinCircleRadius(max1Radius);
-				handTwo[index()].setContour(contours[max1ContourIndex]);
-				handTwo[index()].setMinRect(minAreaRect(Mat(contours[max1ContourIndex])));
-				handTwo[index()].setPresent(true);
-				//clear right hand
-				handOne[index()].clear();
-			}
+	}
+
+	//Detect the two largest circles that represent hands, if they exist
+	Point2f handCenters[2];
+	for(int i = 0; i < handCount; i++) {
+		handCenters[i] = blobDescriptors[handBlobs[i]].circleCenter;
+	}
+	HandAssignment assignment = assignHands(handCount, handCenters[0], handCenters[1],
+			handOnePresent, handOneCenter, handTwoPresent, handTwoCenter, setting->radius_threshold);
+	handFlowRegions[0] = handFlowRegions[1] = Rect();
+	if(assignment.handOne >= 0) {
+		handOne.current().setBlob(blobDescriptors[handBlobs[assignment.handOne]]);
+		handFlowRegions[0] = handRegions[assignment.handOne];
+	}
+	if(assignment.handTwo >= 0) {
+		handTwo.current().setBlob(blobDescriptors[handBlobs[assignment.handTwo]]);
+		handFlowRegions[1] = handRegions[assignment.handTwo];
+	}
+	handOne.current().updateVelocity(handOne.previous());
+	handTwo.current().updateVelocity(handTwo.previous());
+}
+/**
+ * Fill the contours of the present hands into handLabels, so handAt() is a single pixel
+ * read instead of a point in polygon test per feature and hand. Only the regions written
+ * for the previous frame are cleared. Hand one is drawn last so it wins where the hands
+ * overlap, as it was tested first before.
+ */
+void rasterizeHands(const vector<vector<cv::Point> >& contours, Size size) {
+	if(handLabels.size() != size) {
+		handLabels.create(size, CV_8UC1);
+		handLabels.setTo(Scalar(0));
+		labeledRegions.clear();
+	}
+	for(uint i = 0; i < labeledRegions.size(); i++) {
+		handLabels(labeledRegions[i]).setTo(Scalar(0));
+	}
+	labeledRegions.clear();
+
+	Rect frame(0, 0, size.width, size.height);
+	Hand* hands[2] = {&handTwo.current(), &handOne.current()};
+	int labels[2] = {2, 1};
+	for(int i = 0; i < 2; i++) {
+		if(!hands[i]->isPresent()) {
+			continue;
 		}
-	} else {
-		handTwo[index()].clear();
-		handOne[index()].clear();
+		int contour = hands[i]->getContourIndex();
+		drawContours(handLabels, contours, contour, Scalar(labels[i]), CV_FILLED);
+		labeledRegions.push_back(boundingRect(Mat(contours[contour])) & frame);
 	}
 }
+
+/**
+ * Return 1 or 2 if point lies in hand one or hand two of the current frame, 0 otherwise
+ */
+int handAt(Point2f point) {
+	int x = cvRound(point.x), y = cvRound(point.y);
+	if(x < 0 || y < 0 || x >= handLabels.cols || y >= handLabels.rows) {
+		return 0;
+	}
+	return handLabels.at<uchar>(y, x);
+}
+
 /**
  * calculate feature matrix for each hand in the temporal window that just passed and store it in each hand matrix
- * @precondition: this method should be called after findHands() has been called for current index()
+ * @precondition: this method should be called after findHands() has been called for the current hands
  * this method runs for every frame
  */
 void setFeatureMats() {
-    if(handOne.at(index()).isPresent()) {
-        Hand h = handOne.at(index());
-        Moments m = handOne.at(index()).getMoments();
-        logMatrixOne.pop_back(1);
-        Mat tmpMatrix = (Mat_<float>(1, log_num_cols) << record_number,
-                         m.m00, m.m01, m.m02, m.m03, m.m10, m.m11, m.m12, m.m20, m.m21, m.m30,
-                         h.getMinRect().center.x, h.getMinRect().center.y,
-                         h.getMinRect().size.width, h.getMinRect().size.height, h.getMinRect().angle,
-                         h.getFeatureMean().x, h.getFeatureMean().y, h.getFeatureStdDev(),
-                         h.getMinCircleCenter().x, h.getMinCircleCenter().y, h.getMinCircleRadius());
-        int offset = 22; //number of values added above
-        for(int i = 0, j = offset; i < maxCorners; i++, j+=5) {
-            if(h.getFeatures().size() > i) {
-                tmpMatrix.at<float>(0, j) = h.getFeatures()[i].x;
-                tmpMatrix.at<float>(0, j + 1) = h.getFeatures()[i].y;
-                tmpMatrix.at<float>(0, j + 2) = h.getFeaturesDepth()[i];
-                tmpMatrix.at<float>(0, j + 3) = h.getVectors()[i].x;
-                tmpMatrix.at<float>(0, j + 4) = h.getVectors()[i].y;
-            } else {
-                tmpMatrix.at<float>(0, j) = 0;
-                tmpMatrix.at<float>(0, j + 1) = 0;
-                tmpMatrix.at<float>(0, j + 2) = 0;
-                tmpMatrix.at<float>(0, j + 3) = 0;
-                tmpMatrix.at<float>(0, j + 4) = 0;
-            }
-        }
-        tmpMatrix.push_back(logMatrixOne);
-        logMatrixOne = tmpMatrix;
+    if(handOne.current().isPresent()) {
+        setLogRow(logMatrixOne, logRowOne, handOne.current());
+        logRowOne = (logRowOne + 1) % hand_window_size;
     }
-    if(handTwo.at(index()).isPresent()) {
-        Hand h = handTwo.at(index());
-        Moments m = handTwo.at(index()).getMoments();
-        logMatrixTwo.pop_back(1);
-        Mat tmpMatrix = (Mat_<float>(1, log_num_cols) << record_number,
-                         m.m00, m.m01, m.m02, m.m03, m.m10, m.m11, m.m12, m.m20, m.m21, m.m30,
-                         h.getMinRect().center.x, h.getMinRect().center.y,
-                         h.getMinRect().size.width, h.getMinRect().size.height, h.getMinRect().angle,
-                         h.getFeatureMean().x, h.getFeatureMean().y, h.getFeatureStdDev(),
-                         h.getMinCircleCenter().x, h.getMinCircleCenter().y, h.getMinCircleRadius());
-        int offset = 22; //number of values added above
-        for(int i = 0, j = offset; i < maxCorners; i++, j+=5) {
-            if(h.getFeatures().size() > i) {
-                tmpMatrix.at<float>(j) = h.getFeatures()[i].x;
-                tmpMatrix.at<float>(j + 1) = h.getFeatures()[i].y;
-                tmpMatrix.at<float>(j + 2) = h.getFeaturesDepth()[i];
-                tmpMatrix.at<float>(j + 3) = h.getVectors()[i].x;
-                tmpMatrix.at<float>(j + 4) = h.getVectors()[i].y;
-            } else {
-                tmpMatrix.at<float>(0, j) = 0;
-                tmpMatrix.at<float>(0, j + 1) = 0;
-                tmpMatrix.at<float>(0, j + 2) = 0;
-                tmpMatrix.at<float>(0, j + 3) = 0;
-                tmpMatrix.at<float>(0, j + 4) = 0;
-            }
-        }
-        tmpMatrix.push_back(logMatrixTwo);
-        logMatrixTwo = tmpMatrix;
+    if(handTwo.current().isPresent()) {
+        setLogRow(logMatrixTwo, logRowTwo, handTwo.current());
+        logRowTwo = (logRowTwo + 1) % hand_window_size;
+    }
+}
+
+/**
+ * Overwrite one row of a log matrix with the moments, shape and features of h.
+ * Values that h does not have are zero.
+ */
+void setLogRow(Mat& log, int row, Hand& h) {
+    float* values = log.ptr<float>(row);
+    std::fill(values, values + log.cols, 0.0f);
+    Moments m = h.getMoments();
+    float shape[] = {(float)record_number,
+                     (float)m.m00, (float)m.m01, (float)m.m02, (float)m.m03, (float)m.m10,
+                     (float)m.m11, (float)m.m12, (float)m.m20, (float)m.m21, (float)m.m30,
+                     h.getMinRect().center.x, h.getMinRect().center.y,
+                     h.getMinRect().size.width, h.getMinRect().size.height, h.getMinRect().angle,
+                     h.getFeatureMean().x, h.getFeatureMean().y, (float)h.getFeatureStdDev(),
+                     h.getMinCircleCenter().x, h.getMinCircleCenter().y, (float)h.getMinCircleRadius()};
+    int offset = sizeof(shape) / sizeof(shape[0]);
+    std::copy(shape, shape + offset, values);
+    const HandFeatures& features = h.getFeatures();
+    for(int i = 0, j = offset; i < maxCorners && i < features.count; i++, j+=5) {
+        values[j] = features.x[i];
+        values[j + 1] = features.y[i];
+        values[j + 2] = features.depth[i];
+        values[j + 3] = features.dx[i];
+        values[j + 4] = features.dy[i];
     }
 }
 
+/**
+ * Copy of a log matrix with its newest row, the one before next, first
+ */
+Mat orderedLog(const Mat& log, int next) {
+    Mat ordered(log.size(), log.type());
+    for(int i = 0; i < log.rows; i++) {
+        Mat row = ordered.row(i);
+        log.row((next - 1 - i + 2 * log.rows) % log.rows).copyTo(row);
+    }
+    return ordered;
+}
+
 /**
  * saves up to two records in the log file depending on how many hands are present
  * takes gst as an string argument (for gesture such as "grab" and "release")
@@ -918,34 +1145,34 @@ void saveRecord(string gst, int hand_number) {
         logFile << "gesture" << gst;
         logFile << "raw_time" << (float)rawtime;
         logFile << "time" << time_str;
-        logFile << "hand_side" << handOne.at(index()).getHandSide();
-        logFile << "features" << logMatrixOne;
+        logFile << "hand_side" << handOne.current().getHandSide();
+        logFile << "features" << orderedLog(logMatrixOne, logRowOne);
 
         //save data to second log file (csv format)
         logFile2    <<  record_number << ','
                     << frameCount << ','
-                    << handOne.at(index()).getHandSide() << ','
+                    << handOne.current().getHandSide() << ','
                     << gst << ','
                     << rawtime << ','
                     << time_str << ','
                     << fps << ',';
         for (int i = 0; i < hand_window_size; i++) {
-            if(handOne.at(previousIndex(i)).isPresent()) {
+            if(handOne.previous(i).isPresent()) {
                 logFile2 << i << ','
-                << handOne.at(previousIndex(i)).getMinRect().center.x << ','
-                << handOne.at(previousIndex(i)).getMinRect().center.y << ','
-                << handOne.at(previousIndex(i)).getMinRect().size.width << ','
-                << handOne.at(previousIndex(i)).getMinRect().size.height << ','
-                << handOne.at(previousIndex(i)).getMinRect().angle << ','
-                << handOne.at(previousIndex(i)).getMinCircleCenter().x << ','
-                << handOne.at(previousIndex(i)).getMinCircleCenter().y << ','
-                << handOne.at(previousIndex(i)).getMinCircleRadius() << ','
-                << handOne.at(previousIndex(i)).getMassCenter().x << ','
-                << handOne.at(previousIndex(i)).getMassCenter().y << ','
-                << handOne.at(previousIndex(i)).getFeatureMean().x << ','
-                << handOne.at(previousIndex(i)).getFeatureMean().y << ','
-                << handOne.at(previousIndex(i)).getFeatureStdDev() << ','
-                << handOne.at(previousIndex(i)).getNumOfFeatures() << ',';
+                << handOne.previous(i).getMinRect().center.x << ','
+                << handOne.previous(i).getMinRect().center.y << ','
+                << handOne.previous(i).getMinRect().size.width << ','
+                << handOne.previous(i).getMinRect().size.height << ','
+                << handOne.previous(i).getMinRect().angle << ','
+                << handOne.previous(i).getMinCircleCenter().x << ','
+                << handOne.previous(i).getMinCircleCenter().y << ','
+                << handOne.previous(i).getMinCircleRadius() << ','
+                << handOne.previous(i).getMassCenter().x << ','
+                << handOne.previous(i).getMassCenter().y << ','
+                << handOne.previous(i).getFeatureMean().x << ','
+                << handOne.previous(i).getFeatureMean().y << ','
+                << handOne.previous(i).getFeatureStdDev() << ','
+                << handOne.previous(i).getNumOfFeatures() << ',';
             } else {
                 logFile2 << i << ",0,0,0,0, 0,0,0,0,0, 0,0,0,0,0,"; //should match the number of fields added in the if segment above
             }
@@ -959,34 +1186,34 @@ void saveRecord(string gst, int hand_number) {
         logFile << "gesture" << gst;
         logFile << "raw_time" << (float)rawtime;
         logFile << "time" << time_str;
-        logFile << "hand_side" << handTwo.at(index()).getHandSide();
-        logFile << "features" << logMatrixTwo;
+        logFile << "hand_side" << handTwo.current().getHandSide();
+        logFile << "features" << orderedLog(logMatrixTwo, logRowTwo);
 
         //save data to second log file (csv format)
         logFile2    <<  record_number << ','
                     << frameCount << ','
-                    << handTwo.at(index()).getHandSide() << ','
+                    << handTwo.current().getHandSide() << ','
                     << gst << ','
                     << rawtime << ','
                     << time_str << ','
                     << fps << ',';
         for (int i = 0; i < hand_window_size; i++) {
-            if(handTwo.at(previousIndex(i)).isPresent()) {
+            if(handTwo.previous(i).isPresent()) {
                 logFile2 << i << ','
-                << handTwo.at(previousIndex(i)).getMinRect().center.x << ','
-                << handTwo.at(previousIndex(i)).getMinRect().center.y << ','
-                << handTwo.at(previousIndex(i)).getMinRect().size.width << ','
-                << handTwo.at(previousIndex(i)).getMinRect().size.height << ','
-                << handTwo.at(previousIndex(i)).getMinRect().angle << ','
-                << handTwo.at(previousIndex(i)).getMinCircleCenter().x << ','
-                << handTwo.at(previousIndex(i)).getMinCircleCenter().y << ','
-                << handTwo.at(previousIndex(i)).getMinCircleRadius() << ','
-                << handTwo.at(previousIndex(i)).getMassCenter().x << ','
-                << handTwo.at(previousIndex(i)).getMassCenter().y << ','
-                << handTwo.at(previousIndex(i)).getFeatureMean().x << ','
-                << handTwo.at(previousIndex(i)).getFeatureMean().y << ','
-                << handTwo.at(previousIndex(i)).getFeatureStdDev() << ','
-                << handTwo.at(previousIndex(i)).getNumOfFeatures() << ',';
+                << handTwo.previous(i).getMinRect().center.x << ','
+                << handTwo.previous(i).getMinRect().center.y << ','
+                << handTwo.previous(i).getMinRect().size.width << ','
+                << handTwo.previous(i).getMinRect().size.height << ','
+                << handTwo.previous(i).getMinRect().angle << ','
+                << handTwo.previous(i).getMinCircleCenter().x << ','
+                << handTwo.previous(i).getMinCircleCenter().y << ','
+                << handTwo.previous(i).getMinCircleRadius() << ','
+                << handTwo.previous(i).getMassCenter().x << ','
+                << handTwo.previous(i).getMassCenter().y << ','
+                << handTwo.previous(i).getFeatureMean().x << ','
+                << handTwo.previous(i).getFeatureMean().y << ','
+                << handTwo.previous(i).getFeatureStdDev() << ','
+                << handTwo.previous(i).getNumOfFeatures() << ',';
             } else {
                 logFile2 << i << ",0,0,0,0, 0,0,0,0,0, 0,0,0,0,0,"; //should match the number of fields added in the if segment above
             }
@@ -1003,120 +1230,87 @@ void saveRecord(string gst, int hand_number) {
  */
 int numberOfHands() {
 	int numberOfHands = 0;
-	if (handOne.at(index()).isPresent()) {
+	if (handOne.current().isPresent()) {
 		numberOfHands++;
 	}
-	if (handTwo.at(index()).isPresent()) {
+	if (handTwo.current().isPresent()) {
 		numberOfHands++;
 	}
 	return numberOfHands;
 }
 
-/**
- * Returns the current index based on the frame count that is used to identify which hand in the
- * handOne and handTwo arrays are corresponding to current frame
- */
-int index() {
-	return frameCount % hand_window_size;
-}
-
-/**
- * return the index of previous hand in the hand temporal window
- */
-int previousIndex() {
-	return (frameCount - 1) % hand_window_size;
-}
-
-/**
- * return ith previous hand from the history.
- * @Precondition: i is smaller than hand_window_size
- */
-int previousIndex(int i) {
-	if(i >= hand_window_size) {
-		verbosePrint("Incorrect index given to previousIndex(int i) function");
-	}
-	return (frameCount - i) % hand_window_size;
-}
-
 /**
  * Draw features based on the hand they belong to
  * @Precondition: assignFeaturedToHand() is executed and leftRightStatus[i] is filled
  */
 void drawFeatures(Mat img) {
 	//First hand
-	if(handOne.at(index()).isPresent()) {
-		vector<Point2f> points = handOne.at(index()).getFeatures();
-		vector<Point2f> vectors = handOne.at(index()).getVectors();
-		vector<float> featureDepth = handOne.at(index()).getFeaturesDepth();
-		vector<Point2f> orientation = handOne.at(index()).getFeatureOrientation();
+	if(handOne.current().isPresent()) {
+		const HandFeatures& features = handOne.current().getFeatures();
 
-		for (uint i = 0; i < points.size(); i++) {
+		for (int i = 0; i < features.count; i++) {
+			Point2f point = features.position(i);
 			//draw feature box
-			rectangle(img, Point(points[i].x - blockSize/2, points[i].y - blockSize/2), Point(points[i].x + blockSize/2, points[i].y + blockSize/2), ORANGE);
+			rectangle(img, Point(point.x - blockSize/2, point.y - blockSize/2), Point(point.x + blockSize/2, point.y + blockSize/2), ORANGE);
 			//TODO: draw feature trace
 //			for(uint j = 0; j+1 < hand_window_size; j++) {
-//				int current = previousIndex(j);
-//				int previous = previousIndex(j + 1);
-//				if(!handOne.at(current).isFeatureTracked(i)) {
-//					continue; //only draw lines if feature is successfully tracked
-//				}
-//				if(handOne.at(current).isPresent() && handOne.at(previous).isPresent()) {
-//					line(img, handOne.at(previous).getFeatureAt(i), handOne.at(current).getFeatureAt(i), ORANGE, 2, 4, 0);
+//				Hand& current = handOne.previous(j);
+//				Hand& previous = handOne.previous(j + 1);
+//				if(current.isPresent() && previous.isPresent()) {
+//					line(img, previous.getFeatureAt(i), current.getFeatureAt(i), ORANGE, 2, 4, 0);
 //				}
 //			}
 
 			//draw feature direction vector
-			line(img, points[i], (points[i] + vectors[i]), ORANGE, 2, 8, 0);
+			line(img, point, (point + features.vector(i) * motion_draw_interval), ORANGE, 2, 8, 0);
 
 			//visualize feature depth and touch with a circle
             int base_radius = 100;
-            int scaled_depth = sqrt( 1 + base_radius * featureDepth[i] / 2);
+            int scaled_depth = sqrt( 1 + base_radius * features.depth[i] / 2);
             if (scaled_depth < 0) {
                 //integer overflow
                 scaled_depth = base_radius;
             }
             if(scaled_depth < base_radius - blockSize) {
-				circle(img, points[i], base_radius - scaled_depth, RED, 1, CV_AA);
+				circle(img, point, base_radius - scaled_depth, RED, 1, CV_AA);
             } else {
                 //visualize touch with a bold red circle
-                circle(img, points[i], blockSize, RED, 6, CV_AA);
+                circle(img, point, blockSize, RED, 6, CV_AA);
             }
 
 			//visualize feature orientation with a line
-			line(img, points[i], points[i] + orientation[i], GREEN, 3, CV_AA);
+			line(img, point, point + features.orientation(i), GREEN, 3, CV_AA);
 		}
 	}
 
 	//Second hand
-	if(handTwo.at(index()).isPresent()) {
-		vector<Point2f> points = handTwo.at(index()).getFeatures();
-		vector<Point2f> vectors = handTwo.at(index()).getVectors();
-		vector<float> featureDepth = handTwo.at(index()).getFeaturesDepth();
-		vector<Point2f> orientation = handTwo.at(index()).getFeatureOrientation();
-		for (uint i = 0; i < points.size(); i++) {
+	if(handTwo.current().isPresent()) {
+		const HandFeatures& features = handTwo.current().getFeatures();
+		for (int i = 0; i < features.count; i++) {
+			Point2f point = features.position(i);
 			//draw feature box
-			rectangle(img, Point(points[i].x - blockSize/2, points[i].y - blockSize/2), Point(points[i].x + blockSize/2, points[i].y + blockSize/2), BLUE);
+			rectangle(img, Point(point.x - blockSize/2, point.y - blockSize/2), Point(point.x + blockSize/2, point.y + blockSize/2), BLUE);
 			//TODO: draw feature trace
 
 			//draw feature direction vector
-			line(img, points[i], (points[i] + vectors[i]), BLUE, 2, 8, 0);
+			line(img, point, (point + features.vector(i) * motion_draw_interval), BLUE, 2, 8, 0);
 
 			//visualize feature depth and touch with a circle
             int base_radius = 100;
-            int scaled_depth = sqrt( 1 + base_radius * featureDepth[i] / 2);
+            int scaled_depth = sqrt( 1 + base_radius * features.depth[i] / 2);
             if (scaled_depth < 0) {
                 //integer overflow
                 scaled_depth = base_radius;
             }
             if(scaled_depth < base_radius - blockSize) {
-				circle(img, points[i], base_radius - scaled_depth, RED, 1, CV_AA);
+				circle(img, point, base_radius - scaled_depth, RED, 1, CV_AA);
             } else {
                 //visualize touch with a bold red circle
-                circle(img, points[i], blockSize, RED, 6, CV_AA);
+                circle(img, point, blockSize, RED, 6, CV_AA);
             }
 
 			//visualize feature orientation with a line
-            line(img, points[i], points[i] + orientation[i], GREEN, 2, CV_AA);
+            line(img, point, point + features.orientation(i), GREEN, 2, CV_AA);
 		}
 	}
 
@@ -1145,46 +1339,60 @@ void drawGrid(Mat img) {
  * the hand temporal window
  */
 void drawMeanAndStdDev(Mat img) {
-	if(handOne.at(index()).isPresent()) {
-		circle(img, handOne.at(index()).getFeatureMean(), handOne.at(index()).getFeatureStdDev(), YELLOW, 1, 4, 0);
-		line(img, handOne.at(index()).getFeatureMean(), handOne.at(index()).getMinRectCenter(), YELLOW, 1, 4, 0);
+	if(handOne.current().isPresent()) {
+		circle(img, handOne.current().getFeatureMean(), handOne.current().getFeatureStdDev(), YELLOW, 1, 4, 0);
+		line(img, handOne.current().getFeatureMean(), handOne.current().getMinRectCenter(), YELLOW, 1, 4, 0);
 	}
-	if(handTwo.at(index()).isPresent()) {
-		circle(img, handTwo.at(index()).getFeatureMean(), handTwo.at(index()).getFeatureStdDev(), YELLOW, 1, 4, 0);
-		line(img, handTwo.at(index()).getFeatureMean(), handTwo.at(index()).getMinRectCenter(), YELLOW, 1, 4, 0);
+	if(handTwo.current().isPresent()) {
+		circle(img, handTwo.current().getFeatureMean(), handTwo.current().getFeatureStdDev(), YELLOW, 1, 4, 0);
+		line(img, handTwo.current().getFeatureMean(), handTwo.current().getMinRectCenter(), YELLOW, 1, 4, 0);
 	}
 }
 
 /**
  * assign features and their corresponding vector to hand(s) if the feature
- * has been successfully tracked and a hand contain it
+ * has been successfully tracked and a hand contain it. Vectors are in pixels per second,
+ * so they do not depend on the frame rate or on skipped frames.
+ * Tracks in no hand, or beyond maxCorners for their hand, are dropped.
  */
 void assignFeaturesToHands() {
-	for(int i = 0; i < maxCorners; i++) {
-		if(flowStatus[i] == 1) {
-			flowCount[i] += 1;
-			if(flowCount[i] > 2) {
-				if(handOne.at(index()).isPresent() && handOne.at(index()).hasPointInside(currentCorners[i])) {
-					//point is inside contour of the left hand
-					Point2f vector = currentCorners[i] - previousCorners[i];
-
-					Point2f orientation = currentCorners[i] - handOne.at(index()).getMinRectCenter();
-//					Point2f orientation = Point2f(currentCorners[i].x - handOne.at(index()).getMinRectCenter().x,
-//							currentCorners[i].y - handOne.at(index()).getMinRectCenter().y);
-					handOne.at(index()).addFeatureAndVector(currentCorners[i], vector, featureDepth[i], orientation, flowStatus[i]);
-				} else if(handTwo.at(index()).isPresent() && handTwo.at(index()).hasPointInside(currentCorners[i])) {
-					Point2f vector = currentCorners[i] - previousCorners[i];
-                    Point2f orientation = currentCorners[i] - handTwo.at(index()).getMinRectCenter();
-					handTwo.at(index()).addFeatureAndVector(currentCorners[i], vector, featureDepth[i], orientation, flowStatus[i]);
-				} else {
-					//this is noise or some other object
-					//Don't worry about it!
-				}
+	vector<FeatureTrack>& tracks = featureTracker.getTracks();
+	double interval = frameTimestamp - previousFrameTimestamp;
+	float perSecond = (previousFrameTimestamp > 0 && interval > 0) ? (float)(1 / interval) : 0;
+	int handFeatures[3] = {0, 0, 0};
+	uint kept = 0;
+	for(uint j = 0; j < tracks.size(); j++) {
+		int hand = handAt(currentCorners[j]);
+		if(hand == 0 || handFeatures[hand] >= maxCorners) {
+			//features off the hands or beyond the budget of their hand are not followed further
+			continue;
+		}
+		handFeatures[hand]++;
+		//tracks are oldest first, so the oldest features of a hand are kept
+		uint i = kept++;
+		tracks[i] = tracks[j];
+		previousCorners[i] = previousCorners[j];
+		currentCorners[i] = currentCorners[j];
+		featureDepth[i] = featureDepth[j];
+		tracks[i].hand = hand;
+		//only features followed for a few frames have a meaningful motion vector
+		if(tracks[i].age > 2) {
+			if(hand == 1) {
+				//point is inside contour of the left hand
+				Point2f vector = (currentCorners[i] - previousCorners[i]) * perSecond;
+				Point2f orientation = currentCorners[i] - handOne.current().getMinRectCenter();
+				handOne.current().addFeature(tracks[i].id, currentCorners[i], vector, featureDepth[i], orientation);
+			} else {
+				Point2f vector = (currentCorners[i] - previousCorners[i]) * perSecond;
+				Point2f orientation = currentCorners[i] - handTwo.current().getMinRectCenter();
+				handTwo.current().addFeature(tracks[i].id, currentCorners[i], vector, featureDepth[i], orientation);
 			}
-		} else {
-			flowCount[i] = 0;
 		}
 	}
+	tracks.resize(kept);
+	previousCorners.resize(kept);
+	currentCorners.resize(kept);
+	featureDepth.resize(kept);
 }
 
 /**
@@ -1199,42 +1407,25 @@ float getDistance(const Point2f a, const Point2f b) {
  * @Precondition: assignFeatureToHands is executed
  */
 void meanAndStdDevExtract() {
-	if(handOne.at(index()).isPresent()) {
-		handOne.at(index()).calcMeanStdDev();
+	if(handOne.current().isPresent()) {
+		handOne.current().calcMeanStdDev();
 	}
-	if(handTwo.at(index()).isPresent()){
-		handTwo.at(index()).calcMeanStdDev();
+	if(handTwo.current().isPresent()){
+		handTwo.current().calcMeanStdDev();
 	}
 }
 
 /**
- * Calculate the depth of each feature based on the blurriness of its window
+ * Calculate the depth of each feature based on the blurriness of its window. The touch image
+ * is only integrated around the hands, then every feature is a constant time lookup. Windows
+ * on the edge of the image are clamped so edge touches still get a depth
  * @Precondition: img is the image showing minEigenValue calculation. Bright pixels in this image represent highly sharp regions
  */
 void featureDepthExtract(Mat img) {
-	Mat featureRegion;
-	Rect rect;
-	//Scalar stdDev;
-	Scalar mean;
-	featureDepth.clear();
-
-	for(int i = 0; i < maxCorners; i++) {
-//		if(leftRightStatus[i] == 1 || leftRightStatus[i] == 2) {
-			//left or right hand feature
-			rect = Rect(int(currentCorners[i].x - blockSize/2), int(currentCorners[i].y - blockSize/2), blockSize, blockSize);
-			if(rect.x < 0 || rect.y < 0 || rect.x + blockSize > img.cols || rect.y + blockSize > img.rows) {
-				//we dont care about the features that are right on the edge
-				featureDepth.push_back(-1);
-				continue;
-			}
-			featureRegion = img(rect);
-			//meanStdDev(featureRegion, mean, stdDev);
-			mean = cv::mean(featureRegion);
-			featureDepth.push_back(mean.val[0]);
-//		} else {
-//			//Doesnt matter if the feature is not assigned to a hand, so set to -1
-//			featureDepth.push_back(-1);
-//		}
+	depthSampler.setImage(img, handRegions, blockSize/2 + 1);
+	featureDepth.resize(currentCorners.size());
+	for(uint i = 0; i < currentCorners.size(); i++) {
+		featureDepth[i] = depthSampler.sample(currentCorners[i], blockSize);
 	}
 }
 
@@ -1250,3 +1441,41 @@ void printKeys() {
         << "'g' - toggle grid (for testing calibration)" << endl
 		<< "'h' - print this message" << endl << endl;
 }
+
+/**
+ * Time the banded image stages on frame with a single thread and with the worker
+ * pool and print the speedup of each. Sharpness is timed on the whole frame, which
+ * is the worst case of two hands covering the view.
+ */
+void reportParallelSpeedup(const Mat& frame) {
+	const int iterations = 20;
+	const char* stages[3] = {"threshold+median", "sharpness", "gray to color"};
+	Mat source = frame.clone();
+	Mat binary, color;
+	vector<Rect> wholeFrame(1, Rect(0, 0, source.cols, source.rows));
+	double seconds[2][3];
+	for(int parallel = 0; parallel < 2; parallel++) {
+		WorkerPool* pool = parallel ? &workers : NULL;
+		bandScheduler.setWorkerPool(pool);
+		sharpness.setWorkerPool(pool);
+		for(int stage = 0; stage < 3; stage++) {
+			double started = captureTime();
+			for(int i = 0; i < iterations; i++) {
+				if(stage == 0) {
+					bandScheduler.thresholdMedian(source, binary, setting->lower_threshold, setting->upper_threshold,
+							setting->median_blur_factor);
+				} else if(stage == 1) {
+					sharpness.compute(source, wholeFrame);
+				} else {
+					bandScheduler.grayToColor(source, color);
+				}
+			}
+			seconds[parallel][stage] = (captureTime() - started) / iterations;
+		}
+	}
+	cout << "Speedup with " << workers.getThreadCount() << " worker threads:" << endl;
+	for(int stage = 0; stage < 3; stage++) {
+		cout << "  " << stages[stage] << ": " << seconds[0][stage] * 1000 << " ms serial, "
+				<< seconds[1][stage] * 1000 << " ms parallel, " << seconds[0][stage] / seconds[1][stage] << "x" << endl;
+	}
+}
@@ -15,9 +15,14 @@
 #include "ml.h"
 #include "cxtypes.h"
 
+class Hand;
+
 void processKey(char key);
-void findHands(std::vector< std::vector<cv::Point> > contours);
+void findHands(std::vector< std::vector<cv::Point> >& contours);
+void rasterizeHands(const std::vector< std::vector<cv::Point> >& contours, cv::Size size);
+int handAt(cv::Point2f point);
 void opencvConnectedComponent(cv::Mat* src, cv::Mat* dst);
+bool runSelfTests();
 void init();
 void setLog2Headers();
 void start();
@@ -25,19 +30,20 @@ void checkGrab();
 void checkRelease();
 void meanAndStdDevExtract();
 void featureDepthExtract(cv::Mat img);
-void findGoodFeatures(cv::Mat frame1, cv::Mat frame2);
+void findGoodFeatures(cv::Mat frame1, cv::Mat frame2, cv::Mat handMask);
 void assignFeaturesToHands();
 void drawFeatures(cv::Mat img);
 void drawMeanAndStdDev(cv::Mat img);
 void drawGrid(cv::Mat img);
 float getDistance(const cv::Point2f a, const cv::Point2f b);
 int numberOfHands();
-int index();
 void updateMessage();
-int previousIndex();
-int previousIndex(int i);
+double predictionHorizon();
 void printKeys();
 void setFeatureMats();
+void setLogRow(cv::Mat& log, int row, Hand& h);
+cv::Mat orderedLog(const cv::Mat& log, int next);
 void saveRecord(std::string gst, int hand_number);
+void reportParallelSpeedup(const cv::Mat& frame);
 
 #endif /* GIBBON_H_ */
@@ -23,6 +23,7 @@
 #include "Hand.h"
 #include "Setting.h"
 #include <utility>
+#include <math.h>
 
 using namespace std;
 
@@ -32,6 +33,10 @@ Hand::Hand(handSide s) {
 	static int handCount;
 	side = s;
 	present = false;
+	contourIndex = -1;
+	flow = false;
+	features.count = 0;
+	timestamp = 0;
 	handNumber = handCount;
 	handGesture = GESTURE_NONE;
 	handCount++;
@@ -67,22 +72,25 @@ void Hand::setPresent(bool p) {
 }
 
 /**
- * return the contour of this hand
+ * return the index of the contour of this hand in the contours of the frame it was found in.
+ * Only valid while that frame is being processed
  */
-vector<cv::Point> Hand::getContour() {
-	return contour;
+int Hand::getContourIndex() {
+	return contourIndex;
 }
 
 /**
- * This function will receive a vector<cv::Point>  as input parameter
- * it sets the contour of the hand as well as the moments of this contour
+ * Take the shape of this hand from the descriptor of its blob and mark it present.
+ * Only the index of the contour is kept, the contours are refilled every frame
  */
-void Hand::setContour(vector<cv::Point> handContour) {
-    contour = handContour;
-    //now set the moment values
-    moments = cv::moments(contour, false);
-    //set the center of mass
-    massCenter = Point2f( moments.m10/moments.m00 , moments.m01/moments.m00 );
+void Hand::setBlob(const BlobDescriptor& blob) {
+	contourIndex = blob.contour;
+	moments = blob.moments;
+	massCenter = blob.massCenter;
+	minRect = blob.minRect;
+	circleCenter = blob.circleCenter;
+	circleRadius = blob.circleRadius;
+	present = true;
 }
 
 /**
@@ -144,67 +152,95 @@ int Hand::handMessageID() {
 }
 
 /**
- * Return the X value of position of hand gesture as a number in the range [0 1]
- * The position depends on the type of gesture and it means the location in which the gesture
- * should be applied to. For example in the case of Grab gesture this may be the intersection
- * of trajectory of most features of the hands.
+ * Take a snapshot of this hand for the output layer. The position goes through filter,
+ * the filter of this physical hand, and is predicted horizon seconds past timestamp to
+ * make up for the latency of tracking and display. Build one state per hand per frame.
+ * Without a filter, as for removing a hand, x and y are 0
  */
-float Hand::getX() {
-//	return gestureX;
-	if( this->getFeatureMean().x == 0) {
-		return (setting->imageSizeX - this->getMinCircleCenter().x) / setting->imageSizeX;
+HandState Hand::getState(double timestamp, OneEuroFilter* filter, double horizon) {
+	HandState state;
+	state.side = side;
+	state.id = handNumber;
+	state.handGesture = handGesture;
+	state.messageID = handMessageID();
+	if(filter != NULL) {
+		filter->filter(getPosition(), timestamp);
+		Point2f predicted = filter->predict(horizon);
+		state.x = (setting->imageSizeX - predicted.x) / setting->imageSizeX;
+		state.y = predicted.y / setting->imageSizeY;
 	} else {
-		//return (setting->imageSize.width - this->getFeatureMean().x) / setting->imageSize.width;
-		float alpha = 0.5f;
-		static float oldX = -1;
-
-		float x = (setting->imageSizeX - this->getFeatureMean().x) / setting->imageSizeX;
-
-		if(oldX != -1)
-		{
-			//TODO: don't use magic number
-			alpha = fabs(x - oldX) / setting->imageSizeX * 2500.0f;
-			alpha = min(1.0f, alpha);
-			x =  alpha*x + (1-alpha)*oldX;
-		}
-
-		oldX = x;
-		return x;
+		state.x = 0;
+		state.y = 0;
 	}
+	state.angle = getAngle();
+	state.vx = velocity.x;
+	state.vy = velocity.y;
+	state.timestamp = timestamp;
+	return state;
+}
 
+/**
+ * Set the capture time in seconds of the frame this hand was found in
+ */
+void Hand::setTimestamp(double timestamp) {
+	this->timestamp = timestamp;
+}
 
+double Hand::getTimestamp() {
+	return timestamp;
 }
 
 /**
- * Return the Y value of position of hand gesture as a number in the range [0 1]
- * The position depends on the type of gesture and it means the location in which the gesture
- * should be applied to. For example in the case of Grab gesture this may be the intersection
- * of trajectory of most features of the hands.
+ * Set the velocity of this hand from previous, the same hand in the previous frame.
+ * The velocity is 0 if either hand is missing or the frames have the same timestamp
  */
-float Hand::getY() {
-//	return gestureY;
-	if(this->getFeatureMean().y == 0) {
-		//if there are no features use min circle center
-		return this->getMinCircleCenter().y / setting->imageSizeY;
+void Hand::updateVelocity(const Hand& previous) {
+	double interval = timestamp - previous.timestamp;
+	if(present && previous.present && interval > 0) {
+		velocity = (minRect.center - previous.minRect.center) * (float)(1 / interval);
 	} else {
-//		return this->getFeatureMean().y / setting->imageSizeY;
-		float alpha = 0.5f;
-		static float oldY = -1;
-
-		float y = this->getFeatureMean().y / setting->imageSizeY;
-
-		if(oldY != -1)
-		{
-			//TODO: don't use magic number
-			alpha = fabs(y - oldY) / setting->imageSizeY * 2500.f;
-			alpha = min(1.0f, alpha);
-			y = alpha*y + (1-alpha)*oldY;
-		}
-
-		oldY = y;
-		return y;
+		velocity = Point2f(0, 0);
+	}
+}
+
+/**
+ * return the motion of the hand in pixels per second
+ */
+Point2f Hand::getVelocity() {
+	return velocity;
+}
+
+/**
+ * Return the position of the hand gesture in pixels. The position depends on the type of
+ * gesture and it means the location in which the gesture should be applied to. For example
+ * in the case of Grab gesture this may be the intersection of trajectory of most features
+ * of the hands. For now it is the mean of the features, or the min circle center without them
+ */
+Point2f Hand::getPosition() {
+	Point2f position = getFeatureMean();
+	if(position.x == 0) {
+		position.x = getMinCircleCenter().x;
 	}
+	if(position.y == 0) {
+		//if there are no features use min circle center
+		position.y = getMinCircleCenter().y;
+	}
+	return position;
+}
 
+/**
+ * Return the X value of position of hand gesture as a number in the range [0 1].
+ * The image is mirrored, so x runs from right to left
+ */
+float Hand::getX() {
+	return (setting->imageSizeX - getPosition().x) / setting->imageSizeX;
+}
+
+/**
+ * Return the Y value of position of hand gesture as a number in the range [0 1]
+ */
+float Hand::getY() {
+	return getPosition().y / setting->imageSizeY;
 }
 
 /**
@@ -240,74 +276,72 @@ float Hand::getFeatureStdDev() {
 }
 
 /**
- * if the point is inside the hand contour returns true, otherwise return false
+ * Set the statistics of the dense flow over this hand, see HandFlow
  */
-bool Hand::hasPointInside(Point2f point) {
-	return cv::pointPolygonTest(Mat(getContour()).reshape(2), point, false) > -1;
+void Hand::setFlow(float divergence, float curl) {
+	flow = true;
+	flowDivergence = divergence;
+	flowCurl = curl;
 }
 
 /**
- * Add location of a features of this hand, the vector associated with it
- * and the approximate depth based on sharpness measurements
+ * return true if setFlow() has been called since the hand was last cleared
  */
-void Hand::addFeatureAndVector(Point2f feature, Point2f vector, float depth, Point2f orientation, uchar status) {
-	features.push_back(feature);
-	vectors.push_back(vector);
-	featureDepth.push_back(depth);
-	featureOrientation.push_back(orientation);
-	flowStatus.push_back(status);
+bool Hand::hasFlow() {
+	return flow;
 }
 
-/**
- * return the number of features associated with this hand
- * @Precondition: addFeatureAndVector has been called for all the features of this hand
- */
-int Hand::getNumOfFeatures() {
-	return features.size();
+float Hand::getFlowDivergence() {
+	return flowDivergence;
 }
 
-/**
- * return a list of features and their associated vectors
- */
-vector<Point2f> Hand::getFeatures() {
-	return features;
+float Hand::getFlowCurl() {
+	return flowCurl;
 }
 
 /**
- * Return a vector of points representing "Movement Vectors" that are
- * associated with features of this hand
+ * Add location of a features of this hand, the vector associated with it
+ * and the approximate depth based on sharpness measurements.
+ * Returns false if the hand already holds max_hand_features features
  */
-vector<Point2f> Hand::getVectors() {
-	return vectors;
-}
-
-vector<float> Hand::getFeaturesDepth() {
-	return featureDepth;
+bool Hand::addFeature(int trackId, Point2f feature, Point2f vector, float depth, Point2f orientation) {
+	if(features.count >= max_hand_features) {
+		return false;
+	}
+	int i = features.count++;
+	features.trackId[i] = trackId;
+	features.x[i] = feature.x;
+	features.y[i] = feature.y;
+	features.dx[i] = vector.x;
+	features.dy[i] = vector.y;
+	features.depth[i] = depth;
+	features.orientationX[i] = orientation.x;
+	features.orientationY[i] = orientation.y;
+	return true;
 }
 
 /**
- * Returns the vector containing feature orientation. This is the anatomical orientation
- * Usually the feature represent a finger tip and this vector represents the direction that
- * the finger is pointing at. This is NOT the movement direction.
+ * return the number of features associated with this hand
+ * @Precondition: addFeature has been called for all the features of this hand
  */
-vector<Point2f> Hand::getFeatureOrientation() {
-	return featureOrientation;
+int Hand::getNumOfFeatures() {
+	return features.count;
 }
 
 /**
- * Return the position of feature at specified index i
+ * return the features of this hand with their movement vectors, depth and orientation.
+ * Orientation is anatomical: usually the feature represents a finger tip and it is the
+ * direction the finger is pointing at. This is NOT the movement direction.
  */
-Point2f Hand::getFeatureAt(int i) {
-	return features[i];
+const HandFeatures& Hand::getFeatures() const {
+	return features;
 }
 
 /**
- * return the flow status of this feature at index i
- * if feature is tracked 1 is returned
- * if feature is NOT tracked this function returns 0
+ * Return the position of feature at specified index i
  */
-uchar Hand::isFeatureTracked(int i) {
-	return flowStatus[i];
+Point2f Hand::getFeatureAt(int i) {
+	return features.position(i);
 }
 
 /**
@@ -322,12 +356,25 @@ bool Hand::hasGesture() {
  * After calling this function you can use getFeatureMean() and getFeatureStdDev()
  */
 void Hand::calcMeanStdDev() {
-	cv::Scalar mean;
-	cv::Scalar stdDev;
-	cv::meanStdDev(Mat(getFeatures()).reshape(2), mean, stdDev);
-	featureMean.x = (float)mean.val[0];
-	featureMean.y = (float)mean.val[1];
-	featureStdDev = (float)(stdDev.val[0] + stdDev.val[1]) / 2;
+	if(features.count == 0) {
+		featureMean = Point2f(0, 0);
+		featureStdDev = 0;
+		return;
+	}
+	double sumX = 0, sumY = 0;
+	for(int i = 0; i < features.count; i++) {
+		sumX += features.x[i];
+		sumY += features.y[i];
+	}
+	double meanX = sumX / features.count, meanY = sumY / features.count;
+	double varianceX = 0, varianceY = 0;
+	for(int i = 0; i < features.count; i++) {
+		varianceX += (features.x[i] - meanX) * (features.x[i] - meanX);
+		varianceY += (features.y[i] - meanY) * (features.y[i] - meanY);
+	}
+	featureMean.x = (float)meanX;
+	featureMean.y = (float)meanY;
+	featureStdDev = (float)(sqrt(varianceX / features.count) + sqrt(varianceY / features.count)) / 2;
 }
 
 /**
@@ -335,12 +382,11 @@ void Hand::calcMeanStdDev() {
  */
 void Hand::clear() {
 	setPresent(false);
+	contourIndex = -1;
+	flow = false;
+	velocity = Point2f(0, 0);
 	handGesture = GESTURE_NONE;
-	features.clear();
-	featureDepth.clear();
-	vectors.clear();
-	featureOrientation.clear();
-	flowStatus.clear();
+	features.count = 0;
 	//TODO: Check for anything else I need to do here to prevent error or release memory
 }
 
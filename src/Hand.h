@@ -23,6 +23,8 @@
 #define HAND_H_
 
 #include "cv.h"
+#include "BlobDescriptor.h"
+#include "OneEuroFilter.h"
 #include <utility>
 
 using namespace cv;
@@ -39,6 +41,46 @@ typedef enum _gesture {
 	GESTURE_TWIST = 3
 } gesture;
 
+/**
+ * Compact copy of what the output layer needs from a hand, see Hand::getState()
+ */
+struct HandState {
+	handSide side;
+	int id; //hand number
+	gesture handGesture;
+	int messageID; //hand number and gesture packed together, see Hand::handMessageID()
+	float x; //filtered and predicted position of the gesture in the range [0 1]
+	float y;
+	float angle;
+	float vx; //motion of the hand centre in pixels per second, plain floats so the state stays trivially copyable
+	float vy;
+	double timestamp; //capture time of the frame the hand was found in
+};
+
+//most features a hand keeps per frame, enough for maxCorners in the hundreds.
+//The arrays live in the history slots, which are allocated once
+const int max_hand_features = 256;
+
+/**
+ * Features of one hand in one frame as parallel fixed capacity arrays, so a hand never
+ * allocates and copying it through the history is cheap
+ */
+struct HandFeatures {
+	int count;
+	int trackId[max_hand_features]; //id of the FeatureTrack each feature comes from
+	float x[max_hand_features];
+	float y[max_hand_features];
+	float dx[max_hand_features]; //motion of the feature since the previous frame
+	float dy[max_hand_features];
+	float depth[max_hand_features]; //relative depth based on sharpness of its region. Higher means closer to screen
+	float orientationX[max_hand_features]; //2D projection of the direction a finger tip feature is pointing at
+	float orientationY[max_hand_features];
+
+	Point2f position(int i) const { return Point2f(x[i], y[i]); }
+	Point2f vector(int i) const { return Point2f(dx[i], dy[i]); }
+	Point2f orientation(int i) const { return Point2f(orientationX[i], orientationY[i]); }
+};
+
 class Hand {
 
 public:
@@ -53,29 +95,34 @@ public:
 	Point2f getMinCircleCenter();
 	void setMinCircleRadius(int radius);
 	int getMinCircleRadius();
-	vector<cv::Point> getContour();
-	void setContour(vector<cv::Point> contour);
+	int getContourIndex();
+	void setBlob(const BlobDescriptor& blob);
 	int getHandNumber();
 	void clear();
 	gesture getGesture();
 	void setGesture(gesture g);
 	int handMessageID();
+	HandState getState(double timestamp, OneEuroFilter* filter, double horizon);
+	void setTimestamp(double timestamp);
+	double getTimestamp();
+	void updateVelocity(const Hand& previous);
+	Point2f getVelocity();
+	Point2f getPosition();
 	float getX();
 	float getY();
 	float getAngle();
 	void setFeatureMeanStdDev(Point2f mean, float stdDev);
 	Point2f getFeatureMean();
 	float getFeatureStdDev();
+	void setFlow(float divergence, float curl);
+	bool hasFlow();
+	float getFlowDivergence();
+	float getFlowCurl();
 	void setNumOfFeatures(int numOfFeatures);
 	int getNumOfFeatures();
-	bool hasPointInside(Point2f point);
-	void addFeatureAndVector(Point2f feature, Point2f vector, float depth, Point2f orientation, uchar flowStatus);
-	vector<Point2f> getFeatures();
-	vector<Point2f> getVectors();
-	vector<float> getFeaturesDepth();
-	vector<Point2f> getFeatureOrientation();
+	bool addFeature(int trackId, Point2f feature, Point2f vector, float depth, Point2f orientation);
+	const HandFeatures& getFeatures() const;
 	Point2f getFeatureAt(int i);
-	uchar isFeatureTracked(int i);
 	void calcMeanStdDev();
 	bool hasGesture();
 	Mat getFeatureMatrix();
@@ -87,15 +134,16 @@ private:
 	handSide side;
 	gesture handGesture;
 	Point2f circleCenter; //center of enclosing circle
-	vector<cv::Point> contour;
-	vector<Point2f> features; //location of features of this hand
-	vector<uchar> flowStatus; //set to 1 if the flow for the corresponding features has been found, 0 otherwise
-	vector<Point2f> vectors; //vector associated with features of this hand that represent the direction in which the feature is moving
-	vector<float> featureDepth; //relative depth of current feature based on sharpness of its region. Higher means closer to screen
-	vector<Point2f> featureOrientation; //Orientation of feature. In case of finger tip it is the normalized 2D projection of the vector in direction the finger is pointing at
+	int contourIndex; //index of the contour of this hand in the contour list of its frame
+	HandFeatures features; //features of this hand that have been followed for a few frames
 	Point2f featureMean; //mean location of features
 	Point2f massCenter;
 	float featureStdDev; //standard deviation of features
+	bool flow; //true when the dense flow statistics below are set for this frame
+	float flowDivergence; //mean divergence of the dense flow over the hand per second, negative when it closes
+	float flowCurl; //mean curl of the dense flow over the hand per second
+	double timestamp; //capture time in seconds of the frame this hand was found in
+	Point2f velocity; //motion of the min rect centre since the previous frame in pixels per second
 
 	int circleRadius; //radius of enclosing circle
 	RotatedRect minRect;
@@ -0,0 +1,185 @@
+/*
+ * HandFlow.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HandFlow.h"
+
+#include <algorithm>
+
+using namespace cv;
+
+//Farneback parameters, tuned for hands a few tens of flow pixels across
+static const double flow_pyr_scale = 0.5;
+static const int flow_levels = 2;
+static const int flow_window = 9;
+static const int flow_iterations = 3;
+static const int flow_poly_n = 5;
+static const double flow_poly_sigma = 1.1;
+
+//flow areas smaller than this, in flow pixels along a side, carry no useful statistics
+static const int min_flow_side = 8;
+
+HandFlow::HandFlow() {
+	frame = NULL;
+	handMask = NULL;
+	downscale = 4;
+	padding = 16;
+	pool = NULL;
+	clear();
+}
+
+/**
+ * downscale is the integer factor the frame is shrunk by before the flow is computed,
+ * padding is added to every side of a hand in frame pixels
+ */
+void HandFlow::setParameters(int downscale, int padding) {
+	this->downscale = std::max(1, downscale);
+	this->padding = std::max(0, padding);
+	clear();
+}
+
+void HandFlow::setWorkerPool(WorkerPool* pool) {
+	this->pool = pool;
+}
+
+/**
+ * Compute the flow of both hands from the previous call to frame. regions[0] and
+ * regions[1] are the bounds of hand one and two in frame, empty when a hand is absent,
+ * and mask is non zero on hand pixels. Hands that were absent in the previous call get
+ * no statistics this time.
+ */
+void HandFlow::compute(const Mat& frame, const Mat& mask, const Rect regions[2]) {
+	this->frame = &frame;
+	handMask = &mask;
+	for(int i = 0; i < 2; i++) {
+		hands[i].region = regions[i];
+	}
+	if(pool != NULL && regions[0].area() > 0 && regions[1].area() > 0) {
+		pool->run(*this, 2);
+	} else {
+		computeHand(hands[0]);
+		computeHand(hands[1]);
+	}
+}
+
+void HandFlow::run(int index, int worker) {
+	computeHand(hands[index]);
+}
+
+/**
+ * Flow statistics of hand one (0) or hand two (1) from the last compute()
+ */
+const FlowStats& HandFlow::getStats(int hand) {
+	return hands[hand].stats;
+}
+
+/**
+ * Forget the stored images, so the next compute() has no previous frame
+ */
+void HandFlow::clear() {
+	for(int i = 0; i < 2; i++) {
+		hands[i].region = Rect();
+		hands[i].stored = Rect();
+		hands[i].stats.valid = false;
+		hands[i].stats.samples = 0;
+	}
+}
+
+/**
+ * Grow r to multiples of downscale inside the frame, so frame and flow rectangles
+ * convert into each other exactly
+ */
+Rect HandFlow::snap(Rect r) {
+	int x0 = r.x / downscale * downscale;
+	int y0 = r.y / downscale * downscale;
+	int x1 = std::min((r.x + r.width + downscale - 1) / downscale, frame->cols / downscale) * downscale;
+	int y1 = std::min((r.y + r.height + downscale - 1) / downscale, frame->rows / downscale) * downscale;
+	if(x1 <= x0 || y1 <= y0) {
+		return Rect();
+	}
+	return Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+void HandFlow::computeHand(HandSlot& hand) {
+	hand.stats.valid = false;
+	hand.stats.samples = 0;
+	if(hand.region.area() == 0) {
+		hand.stored = Rect();
+		return;
+	}
+	Rect frameRect(0, 0, frame->cols, frame->rows);
+	Rect padded(hand.region.x - padding, hand.region.y - padding, hand.region.width + 2 * padding, hand.region.height + 2 * padding);
+	Rect kept(padded.x - padding, padded.y - padding, padded.width + 2 * padding, padded.height + 2 * padding);
+	Rect box = snap(padded & frameRect);
+	kept = snap(kept & frameRect);
+	if(kept.area() == 0) {
+		hand.stored = Rect();
+		return;
+	}
+
+	resize((*frame)(kept), hand.current, Size(kept.width / downscale, kept.height / downscale), 0, 0, INTER_AREA);
+	Rect area = box & hand.stored;
+	if(area.width >= min_flow_side * downscale && area.height >= min_flow_side * downscale) {
+		Rect inPrevious((area.x - hand.stored.x) / downscale, (area.y - hand.stored.y) / downscale,
+				area.width / downscale, area.height / downscale);
+		Rect inCurrent((area.x - kept.x) / downscale, (area.y - kept.y) / downscale, inPrevious.width, inPrevious.height);
+		Mat previousArea = hand.previous(inPrevious);
+		Mat currentArea = hand.current(inCurrent);
+		calcOpticalFlowFarneback(previousArea, currentArea, hand.flow, flow_pyr_scale, flow_levels, flow_window,
+				flow_iterations, flow_poly_n, flow_poly_sigma, 0);
+		resize((*handMask)(area), hand.mask, inCurrent.size(), 0, 0, INTER_NEAREST);
+
+		//central differences of the flow, only where the hand is
+		double divergence = 0, curl = 0, u = 0, v = 0;
+		int samples = 0;
+		for(int y = 1; y + 1 < hand.flow.rows; y++) {
+			const Point2f* above = hand.flow.ptr<Point2f>(y - 1);
+			const Point2f* row = hand.flow.ptr<Point2f>(y);
+			const Point2f* below = hand.flow.ptr<Point2f>(y + 1);
+			const uchar* inHand = hand.mask.ptr<uchar>(y);
+			for(int x = 1; x + 1 < hand.flow.cols; x++) {
+				if(inHand[x] == 0) {
+					continue;
+				}
+				float dudx = (row[x + 1].x - row[x - 1].x) * 0.5f;
+				float dvdx = (row[x + 1].y - row[x - 1].y) * 0.5f;
+				float dudy = (below[x].x - above[x].x) * 0.5f;
+				float dvdy = (below[x].y - above[x].y) * 0.5f;
+				divergence += dudx + dvdy;
+				curl += dvdx - dudy;
+				u += row[x].x;
+				v += row[x].y;
+				samples++;
+			}
+		}
+		if(samples > 0) {
+			//derivatives are ratios, so only the mean flow has to be scaled back to frame pixels
+			hand.stats.valid = true;
+			hand.stats.divergence = divergence / samples;
+			hand.stats.curl = curl / samples;
+			hand.stats.meanFlow = Point2f(u / samples * downscale, v / samples * downscale);
+			hand.stats.samples = samples;
+		}
+	}
+
+	//the kept box of this frame is the previous image of the next one
+	std::swap(hand.previous, hand.current);
+	hand.stored = kept;
+}
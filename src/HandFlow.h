@@ -0,0 +1,83 @@
+/*
+ * HandFlow.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HANDFLOW_H_
+#define HANDFLOW_H_
+
+#include "cv.h"
+#include "WorkerPool.h"
+
+/**
+ * Summary of the dense optical flow over the pixels of one hand
+ */
+struct FlowStats {
+	bool valid; //false when the hand is new or has no flow this frame
+	float divergence; //mean du/dx + dv/dy over the hand per frame, negative when the hand contracts
+	float curl; //mean dv/dx - du/dy over the hand per frame, positive when it turns clockwise on screen
+	cv::Point2f meanFlow; //mean flow over the hand in frame pixels per frame
+	int samples; //number of flow vectors the statistics were taken from
+};
+
+/**
+ * Dense Farneback optical flow computed only inside the padded bounding boxes of the
+ * hands, on the frame shrunk by an integer factor. The two hands are independent
+ * tasks on the WorkerPool when one is set.
+ * Camera frames are not kept by the capture ring, so every hand keeps its own shrunk
+ * copy of a box twice as padded as the flow box, which is the previous image of the
+ * next frame. Flow is only computed where the two boxes overlap.
+ */
+class HandFlow : public WorkerTask {
+
+public:
+	HandFlow();
+	void setParameters(int downscale, int padding);
+	void setWorkerPool(WorkerPool* pool);
+	void compute(const cv::Mat& frame, const cv::Mat& mask, const cv::Rect regions[2]);
+	const FlowStats& getStats(int hand);
+	void clear();
+	void run(int index, int worker);
+
+private:
+	struct HandSlot {
+		cv::Rect region; //bounds of the hand in the current frame, empty when it is absent
+		cv::Rect stored; //part of the frame kept in previous, in frame pixels
+		cv::Mat previous; //shrunk image of stored from the previous frame
+		cv::Mat current; //shrunk image of the kept box of the current frame
+		cv::Mat mask; //shrunk hand mask of the flow area
+		cv::Mat flow;
+		FlowStats stats;
+	};
+
+	void computeHand(HandSlot& hand);
+	cv::Rect snap(cv::Rect r);
+
+	HandSlot hands[2];
+	const cv::Mat* frame; //frame of the current compute()
+	const cv::Mat* handMask; //hand pixels of the current compute()
+	int downscale; //frame pixels per flow pixel along each axis
+	int padding; //frame pixels added around each hand for the flow
+	WorkerPool* pool; //NULL to compute both hands on the calling thread
+
+	HandFlow(const HandFlow&); //Prevent copy-construction
+	HandFlow& operator=(const HandFlow&); //Prevent assignment
+};
+
+#endif /* HANDFLOW_H_ */
@@ -0,0 +1,88 @@
+/*
+ * HandHistory.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HandHistory.h"
+#include "Log.h"
+
+#include <boost/lexical_cast.hpp>
+
+/**
+ * All slots are copies of one hand, so they share its hand number
+ */
+HandHistory::HandHistory(handSide side, int capacity) : slots(capacity, Hand(side)) {
+	head = 0;
+}
+
+/**
+ * Move on to the next frame. The oldest hand becomes current() and keeps its old
+ * content until it is cleared
+ */
+void HandHistory::advance() {
+	head = (head + 1) % slots.size();
+}
+
+/**
+ * Hand of the current frame
+ */
+Hand& HandHistory::current() {
+	return slots[head];
+}
+
+/**
+ * Hand of the previous frame
+ */
+Hand& HandHistory::previous() {
+	return slots[previousIndex(1)];
+}
+
+/**
+ * Hand of i frames ago, previous(0) is current()
+ * @Precondition: i is smaller than size()
+ */
+Hand& HandHistory::previous(int i) {
+	return slots[previousIndex(i)];
+}
+
+/**
+ * Slot of the current frame
+ */
+int HandHistory::index() {
+	return head;
+}
+
+/**
+ * Slot of the hand of i frames ago
+ */
+int HandHistory::previousIndex(int i) {
+	if(i >= (int)slots.size()) {
+		verbosePrint("Incorrect index given to HandHistory::previousIndex(int i) " + boost::lexical_cast<std::string>(i));
+		i %= slots.size();
+	}
+	return (head + slots.size() - i) % slots.size();
+}
+
+int HandHistory::size() {
+	return slots.size();
+}
+
+OneEuroFilter& HandHistory::getFilter() {
+	return filter;
+}
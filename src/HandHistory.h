@@ -0,0 +1,57 @@
+/*
+ * HandHistory.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HANDHISTORY_H_
+#define HANDHISTORY_H_
+
+#include "Hand.h"
+#include "OneEuroFilter.h"
+#include <vector>
+
+/**
+ * Temporal window of one hand: a ring of Hand slots allocated once, with the hand of
+ * the current frame at current() and older ones at previous(i). The ring keeps its own
+ * position, advance() moves it on to the next frame. The filter of the output position
+ * belongs to the history since it follows the physical hand across frames.
+ */
+class HandHistory {
+
+public:
+	HandHistory(handSide side, int capacity);
+	void advance();
+	Hand& current();
+	Hand& previous();
+	Hand& previous(int i);
+	int index();
+	int previousIndex(int i);
+	int size();
+	OneEuroFilter& getFilter();
+
+private:
+	std::vector<Hand> slots;
+	int head; //slot of the current frame
+	OneEuroFilter filter; //smooths and predicts the position sent for this hand
+
+	HandHistory(const HandHistory&); //Prevent copy-construction
+	HandHistory& operator=(const HandHistory&); //Prevent assignment
+};
+
+#endif /* HANDHISTORY_H_ */
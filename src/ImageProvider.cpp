@@ -21,6 +21,20 @@
 
 #include "ImageProvider.h"
 
+#include <iostream>
+
+ImageProvider::ImageProvider() {
+	ring = NULL;
+	capturing = false;
+	capturePolicy = FRAME_POLICY_EVERY;
+	frameHeld = false;
+	sequence = 0;
+}
+
+ImageProvider::~ImageProvider() {
+	stopCapture();
+}
+
 void ImageProvider::init() {
 
 }
@@ -36,3 +50,175 @@ cv::Rect ImageProvider::getROI() {
 void ImageProvider::setROI(cv::Rect roiRect) {
 	roi = roiRect;
 }
+
+/**
+ * Start a thread that keeps grabbing images into a ring of ringSize preallocated frames
+ * so that slow processing never stalls the source. The first image is grabbed here
+ * to find out the size and type of the frames to allocate. policy should be the one
+ * the frames are read with: a live source that is read with FRAME_POLICY_LATEST
+ * recycles its oldest unread frame when the ring is full instead of losing the newest.
+ * */
+void ImageProvider::startCapture(int ringSize, framePolicy policy) {
+	if(ring != NULL) {
+		return;
+	}
+	Frame first;
+	if(!grabFrame(first)) {
+		std::cout << "Error: could not grab the first frame, capture thread not started" << std::endl;
+		return;
+	}
+	//a ring of one would leave the producer nothing to write while a frame is processed
+	ring = new FrameRing(std::max(ringSize, 2), first.image.size(), first.image.type());
+
+	capturePolicy = policy;
+	Frame* slot = ring->beginWrite(FRAME_POLICY_EVERY);
+	first.image.copyTo(slot->image);
+	slot->sequence = first.sequence;
+	slot->timestamp = first.timestamp;
+	ring->endWrite();
+
+	capturing = true;
+	captureThread = boost::thread(&ImageProvider::captureLoop, this);
+}
+
+/**
+ * Stop the capture thread and release the ring. Any frame returned by nextFrame()
+ * must not be used after this call.
+ * */
+void ImageProvider::stopCapture() {
+	capturing = false;
+	if(captureThread.joinable()) {
+		captureThread.join();
+	}
+	delete ring;
+	ring = NULL;
+	frameHeld = false;
+}
+
+bool ImageProvider::isCapturing() {
+	return capturing;
+}
+
+/**
+ * Grab the next image and stamp it with its place in the capture stream.
+ * Returns false at the end of the source. Sources that carry their own sequence
+ * numbers and timestamps, such as raw recordings, override this.
+ * */
+bool ImageProvider::grabFrame(Frame& frame) {
+	frame.image = grabImage();
+	frame.timestamp = captureTime();
+	frame.sequence = sequence++;
+	return !frame.image.empty();
+}
+
+/**
+ * Live sources such as cameras keep producing frames whether or not they are consumed.
+ * Recorded sources return false so that no frame is ever dropped.
+ * */
+bool ImageProvider::isLive() {
+	return true;
+}
+
+/**
+ * Body of the capture thread. For live sources it never waits for the consumer: when
+ * the ring is full the oldest unread frame is recycled under FRAME_POLICY_LATEST and
+ * the new frame is dropped under FRAME_POLICY_EVERY, both are counted as dropped.
+ * Recorded sources wait for the consumer to free a slot instead.
+ * */
+void ImageProvider::captureLoop() {
+	Frame grabbed;
+	while(capturing) {
+		if(!grabFrame(grabbed)) {
+			//end of the source
+			break;
+		}
+		Frame* slot = ring->beginWrite(isLive() ? capturePolicy : FRAME_POLICY_EVERY);
+		while(slot == NULL && !isLive() && capturing) {
+			boost::this_thread::sleep(boost::posix_time::microseconds(200));
+			slot = ring->beginWrite(FRAME_POLICY_EVERY);
+		}
+		if(slot == NULL) {
+			if(isLive()) {
+				ring->countDroppedFrame();
+			}
+			continue;
+		}
+		grabbed.image.copyTo(slot->image);
+		slot->sequence = grabbed.sequence;
+		slot->timestamp = grabbed.timestamp;
+		ring->endWrite();
+	}
+	capturing = false;
+}
+
+/**
+ * Return the next frame to process according to policy, waiting for one if necessary.
+ * The frame stays valid until the next call. Returns NULL when the source has ended.
+ * Without a capture thread the image is grabbed directly on the calling thread.
+ * */
+const Frame* ImageProvider::nextFrame(framePolicy policy) {
+	if(ring == NULL) {
+		if(!grabFrame(directFrame)) {
+			return NULL;
+		}
+		return &directFrame;
+	}
+
+	if(frameHeld) {
+		ring->endRead();
+		frameHeld = false;
+	}
+	for(;;) {
+		//read the flag first so a frame written just before the thread exits is not missed
+		bool running = capturing;
+		const Frame* frame = ring->beginRead(policy);
+		if(frame != NULL) {
+			frameHeld = true;
+			return frame;
+		}
+		if(!running) {
+			//capture thread has finished and everything it wrote has been consumed
+			return NULL;
+		}
+		boost::this_thread::sleep(boost::posix_time::microseconds(200));
+	}
+}
+
+/**
+ * Like nextFrame() but never waits: returns NULL if the capture thread has no new frame
+ * yet, or if there is no capture thread at all.
+ * */
+const Frame* ImageProvider::tryNextFrame(framePolicy policy) {
+	if(ring == NULL) {
+		return NULL;
+	}
+	if(frameHeld) {
+		ring->endRead();
+		frameHeld = false;
+	}
+	const Frame* frame = ring->beginRead(policy);
+	if(frame != NULL) {
+		frameHeld = true;
+	}
+	return frame;
+}
+
+/**
+ * Number of frames lost because processing could not keep up with the source
+ * */
+unsigned long ImageProvider::getDroppedFrames() {
+	if(ring == NULL) {
+		return 0;
+	}
+	return ring->getDroppedFrames();
+}
+
+/**
+ * Number of frames skipped by FRAME_POLICY_LATEST to keep processing on the newest frame
+ * */
+unsigned long ImageProvider::getSkippedFrames() {
+	if(ring == NULL) {
+		return 0;
+	}
+	return ring->getSkippedFrames();
+}
@@ -24,19 +24,45 @@
 
 #include "cv.h"
 #include "ImageUtils.h"
+#include "FrameRing.h"
 // TODO: find the right include above and remove the unnecessary ones.
 
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+
 class ImageProvider {
 	public:
+		ImageProvider();
+		virtual ~ImageProvider();
 		virtual cv::Mat grabImage() = 0;
 		virtual void init();
 		virtual void setROI(cv::Rect roi);
 		virtual cv::Rect getROI();
+		void startCapture(int ringSize, framePolicy policy = FRAME_POLICY_EVERY);
+		void stopCapture();
+		bool isCapturing();
+		const Frame* nextFrame(framePolicy policy);
+		const Frame* tryNextFrame(framePolicy policy);
+		unsigned long getDroppedFrames();
+		unsigned long getSkippedFrames();
 
 	protected:
+		virtual bool grabFrame(Frame& frame);
+		virtual bool isLive();
+
 		float fps; //TODO: figure out if fps should be set and accessible from here
 		cv::Rect roi; //region of interest
 
+	private:
+		void captureLoop();
+
+		FrameRing* ring; //frames filled by the capture thread, NULL when not capturing
+		boost::thread captureThread;
+		boost::atomic<bool> capturing;
+		framePolicy capturePolicy; //policy the consumer reads with, decides what a full ring gives up
+		bool frameHeld; //true while the consumer holds a frame from the ring
+		unsigned long sequence; //sequence number of the next grabbed frame
+		Frame directFrame; //frame returned by nextFrame() when there is no capture thread
 };
 
 #endif /* CAMERA_H_ */
@@ -21,8 +21,11 @@
 
 #include "ImageUtils.h"
 #include "Setting.h"
+#include "SharpnessEngine.h"
 #include "cv.h"
 
+#include <algorithm>
+
 using namespace cv;
 
 #define setting Setting::Instance()
@@ -35,7 +38,105 @@ using namespace cv;
  */
 void sharpnessImage(Mat sourceImg, Mat touchImg) {
 	// blockSize define the window to consider around each pixel, so higher number produces larger blocks in the image
-    cv::cornerMinEigenVal(sourceImg, touchImg, 16, 9);
+    cv::cornerMinEigenVal(sourceImg, touchImg, sharpness_block_size, sharpness_aperture_size);
+}
+
+/**
+ * threshold(source, dst, thresh, maxValue, THRESH_BINARY) followed by medianBlur(dst, dst, size),
+ * in one pass over the rows of dst in rows. The median of a two level image is a majority vote,
+ * so it is found from running counts of the pixels above thresh, in constant time per pixel
+ * whatever the size. The border is replicated like medianBlur does. counts is scratch space.
+ */
+void binaryMajorityFilter(const Mat& source, Mat& dst, Range rows, double thresh, double maxValue,
+		int size, std::vector<ushort>& counts) {
+	CV_Assert(source.type() == CV_8UC1 && dst.type() == CV_8UC1 && dst.size() == source.size());
+	CV_Assert(size % 2 == 1 && source.data != dst.data);
+	//same rounding as threshold() on 8 bit images
+	int level = cvFloor(thresh);
+	uchar on = (uchar)std::min(std::max(cvRound(maxValue), 0), 255);
+	int radius = size / 2;
+	int majority = size * size / 2; //the median is set when more pixels than this are set
+	int width = source.cols;
+	int last = source.rows - 1;
+
+	//number of set pixels in the window rows of each column, padded by the radius on both sides
+	counts.assign(width + 2 * radius, 0);
+	ushort* column = &counts[radius];
+	for(int dy = -radius; dy <= radius; dy++) {
+		const uchar* s = source.ptr(std::min(std::max(rows.start + dy, 0), last));
+		for(int x = 0; x < width; x++) {
+			column[x] += s[x] > level;
+		}
+	}
+
+	for(int y = rows.start; y < rows.end; y++) {
+		if(y > rows.start) {
+			//slide the window down one row
+			const uchar* added = source.ptr(std::min(y + radius, last));
+			const uchar* removed = source.ptr(std::max(y - radius - 1, 0));
+			for(int x = 0; x < width; x++) {
+				column[x] += (added[x] > level) - (removed[x] > level);
+			}
+		}
+		for(int k = 1; k <= radius; k++) {
+			column[-k] = column[0];
+			column[width - 1 + k] = column[width - 1];
+		}
+		int sum = 0;
+		for(int x = -radius; x < radius; x++) {
+			sum += column[x];
+		}
+		uchar* d = dst.ptr(y);
+		for(int x = 0; x < width; x++) {
+			sum += column[x + radius];
+			d[x] = sum > majority ? on : 0;
+			sum -= column[x - radius];
+		}
+	}
+}
+
+/**
+ * Compare binaryMajorityFilter with threshold followed by medianBlur on blurred noise of
+ * odd sizes, for kernel sizes 3 to 21, thresholds at the edges of the 8 bit range and
+ * the image split in uneven bands. Returns false if any pixel differs.
+ */
+bool binaryMajorityFilterSelfTest(std::ostream& out) {
+	Size sizes[2] = {Size(665, 374), Size(123, 77)};
+	double thresholds[5] = {0, 0.5, 127.5, 254, 255};
+	std::vector<ushort> counts;
+	Mat thresholded, reference, result, difference;
+	int cases = 0, failures = 0;
+	RNG rng(12345);
+	for(int s = 0; s < 2; s++) {
+		Mat source(sizes[s], CV_8UC1);
+		rng.fill(source, RNG::UNIFORM, Scalar(0), Scalar(256));
+		GaussianBlur(source, source, Size(0, 0), 2);
+		//full range, so thresholds 0 and 254 have pixels on both sides
+		source.at<uchar>(0, 0) = 0;
+		source.at<uchar>(source.rows - 1, source.cols - 1) = 255;
+		result.create(source.size(), CV_8UC1);
+		for(int size = 3; size <= 21; size += 2) {
+			for(int t = 0; t < 5; t++) {
+				threshold(source, thresholded, thresholds[t], 255, THRESH_BINARY);
+				medianBlur(thresholded, reference, size);
+				//three bands of uneven height, as the band scheduler may split the frame
+				int first = source.rows / 5, second = source.rows / 2 + 1;
+				binaryMajorityFilter(source, result, Range(0, first), thresholds[t], 255, size, counts);
+				binaryMajorityFilter(source, result, Range(first, second), thresholds[t], 255, size, counts);
+				binaryMajorityFilter(source, result, Range(second, source.rows), thresholds[t], 255, size, counts);
+				absdiff(result, reference, difference);
+				int differing = countNonZero(difference);
+				if(differing > 0) {
+					out << "Binary majority filter " << source.cols << "x" << source.rows << " size " << size
+						<< " threshold " << thresholds[t] << ": " << differing << " pixels differ from threshold + medianBlur" << std::endl;
+					failures++;
+				}
+				cases++;
+			}
+		}
+	}
+	out << "Binary majority filter self test " << (failures == 0 ? "passed" : "FAILED") << ", " << cases - failures << " of " << cases << " cases identical" << std::endl;
+	return failures == 0;
 }
 
 /**
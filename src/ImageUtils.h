@@ -23,8 +23,13 @@
 #define IMAGEUTILS_H_
 
 #include "cv.h"
+#include <vector>
+#include <ostream>
 
 void sharpnessImage(cv::Mat sourceImg, cv::Mat depthImg);
+void binaryMajorityFilter(const cv::Mat& source, cv::Mat& dst, cv::Range rows, double thresh, double maxValue,
+		int size, std::vector<ushort>& counts);
+bool binaryMajorityFilterSelfTest(std::ostream& out);
 void rotateImage(cv::Mat* src, cv::Mat* dst, float degrees);
 
 
@@ -53,10 +53,10 @@ void Message::init() {
  * for this hand and any gestures associated with it
  */
 
-void Message::newHand(Hand hand) {
+void Message::newHand(const HandState& hand) {
 	if(setting->send_tuio) {
-		//handList[hand.getHandNumber()] = TuioObject(tuioTime, 0, hand.handMessageID(), hand.getX(), hand.getY(), hand.getAngle());
-                handList[hand.getHandSide()] = tuioServer->addTuioObject(hand.handMessageID(), hand.getX(), hand.getY(), hand.getAngle());
+		//handList[hand.id] = TuioObject(tuioTime, 0, hand.messageID, hand.x, hand.y, hand.angle);
+                handList[hand.side] = tuioServer->addTuioObject(hand.messageID, hand.x, hand.y, hand.angle);
 	}
 }
 
@@ -64,19 +64,19 @@ void Message::newHand(Hand hand) {
  * for updating an existing hand. New gestures will be retrived from the hand and sent over using
  * appropriate protocols such as TUIO
  */
-void Message::updateHand(Hand hand) {
+void Message::updateHand(const HandState& hand) {
 	if(setting->send_tuio) {
-            tuioServer->updateTuioObject(handList[hand.getHandSide()], hand.getX(), hand.getY(), hand.getAngle());
-            //tuioServer->updateTuioObject(handList[hand.getHandSide()], .1f, .1f, .2f);
+            tuioServer->updateTuioObject(handList[hand.side], hand.x, hand.y, hand.angle);
+            //tuioServer->updateTuioObject(handList[hand.side], .1f, .1f, .2f);
 	}
 }
 
 /**
  * send the message that this hand is not present
  */
-void Message::removeHand(Hand hand) {
+void Message::removeHand(const HandState& hand) {
 	if(setting->send_tuio) {
-		tuioServer->removeTuioObject(handList[hand.getHandSide()]);
+		tuioServer->removeTuioObject(handList[hand.side]);
 	}
 }
 
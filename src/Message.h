@@ -33,9 +33,9 @@ class Message {
 public:
 	Message();
 	void init();
-	void newHand(Hand hand);
-	void updateHand(Hand hand);
-	void removeHand(Hand hand);
+	void newHand(const HandState& hand);
+	void updateHand(const HandState& hand);
+	void removeHand(const HandState& hand);
 	void commit();
 	~Message();
 
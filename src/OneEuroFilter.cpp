@@ -0,0 +1,96 @@
+/*
+ * OneEuroFilter.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OneEuroFilter.h"
+
+#include <math.h>
+
+using namespace cv;
+
+OneEuroFilter::OneEuroFilter() {
+	minCutoff = 1;
+	beta = 0.01f;
+	derivativeCutoff = 1;
+	reset();
+}
+
+/**
+ * Lower minCutoff removes more jitter when still, higher beta removes more lag when moving
+ */
+void OneEuroFilter::setParameters(float minCutoff, float beta, float derivativeCutoff) {
+	this->minCutoff = minCutoff;
+	this->beta = beta;
+	this->derivativeCutoff = derivativeCutoff;
+}
+
+/**
+ * Forget the past samples, the next one is taken as it is. Call when a new hand appears
+ */
+void OneEuroFilter::reset() {
+	initialized = false;
+	lastTimestamp = 0;
+	position = Point2f(0, 0);
+	velocity = Point2f(0, 0);
+}
+
+/**
+ * Weight of a new sample in an exponential low pass filter with the given cutoff frequency
+ */
+float OneEuroFilter::smoothing(float cutoff, double interval) {
+	double tau = 1 / (2 * CV_PI * cutoff);
+	return (float)(1 / (1 + tau / interval));
+}
+
+/**
+ * Add a sample taken at timestamp (seconds) and return the filtered position.
+ * A sample no newer than the previous one only returns the filtered position
+ */
+Point2f OneEuroFilter::filter(Point2f sample, double timestamp) {
+	if(!initialized) {
+		initialized = true;
+		lastTimestamp = timestamp;
+		position = sample;
+		velocity = Point2f(0, 0);
+		return position;
+	}
+	double interval = timestamp - lastTimestamp;
+	if(interval <= 0) {
+		return position;
+	}
+	lastTimestamp = timestamp;
+
+	Point2f rawVelocity = (sample - position) * (float)(1 / interval);
+	float a = smoothing(derivativeCutoff, interval);
+	velocity = velocity + (rawVelocity - velocity) * a;
+
+	float speed = sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+	a = smoothing(minCutoff + beta * speed, interval);
+	position = position + (sample - position) * a;
+	return position;
+}
+
+/**
+ * Filtered position extrapolated horizon seconds after the last sample with the filtered
+ * velocity
+ */
+Point2f OneEuroFilter::predict(double horizon) {
+	return position + velocity * (float)horizon;
+}
@@ -0,0 +1,54 @@
+/*
+ * OneEuroFilter.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ONEEUROFILTER_H_
+#define ONEEUROFILTER_H_
+
+#include "cv.h"
+
+/**
+ * One Euro filter of a 2D position (Casiez et al. 2012): a low pass filter whose cutoff
+ * frequency rises with speed, so a still hand does not jitter and a moving hand does not
+ * lag. The filtered speed is also used to predict the position a short time ahead.
+ * Samples carry their own timestamps, so the filter does not depend on the frame rate.
+ */
+class OneEuroFilter {
+
+public:
+	OneEuroFilter();
+	void setParameters(float minCutoff, float beta, float derivativeCutoff);
+	void reset();
+	cv::Point2f filter(cv::Point2f position, double timestamp);
+	cv::Point2f predict(double horizon);
+
+private:
+	static float smoothing(float cutoff, double interval);
+
+	float minCutoff; //cutoff frequency in Hz of a still position
+	float beta; //cutoff increase in Hz per pixel per second of speed
+	float derivativeCutoff; //cutoff frequency in Hz of the speed
+	bool initialized; //false until the first sample after reset()
+	double lastTimestamp;
+	cv::Point2f position; //filtered position in pixels
+	cv::Point2f velocity; //filtered velocity in pixels per second
+};
+
+#endif /* ONEEUROFILTER_H_ */
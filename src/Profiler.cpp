@@ -0,0 +1,102 @@
+/*
+ * Profiler.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Profiler.h"
+#include "FrameRing.h"
+
+#include <algorithm>
+#include <iomanip>
+
+Profiler::Profiler() {
+	enabled = false;
+}
+
+void Profiler::setEnabled(bool enabled) {
+	this->enabled = enabled;
+}
+
+bool Profiler::isEnabled() {
+	return enabled;
+}
+
+/**
+ * Start timing stage. Every begin() must be followed by an end() of the same stage.
+ */
+void Profiler::begin(const std::string& stage) {
+	if(!enabled) {
+		return;
+	}
+	if(stages.find(stage) == stages.end()) {
+		order.push_back(stage);
+	}
+	stages[stage].started = captureTime();
+}
+
+/**
+ * Stop timing stage and record the time since the matching begin()
+ */
+void Profiler::end(const std::string& stage) {
+	if(!enabled) {
+		return;
+	}
+	Stage& s = stages[stage];
+	s.samples.push_back(captureTime() - s.started);
+}
+
+/**
+ * Record a duration that was measured elsewhere, e.g. the latency from capture to output
+ */
+void Profiler::addSample(const std::string& stage, double seconds) {
+	if(!enabled) {
+		return;
+	}
+	if(stages.find(stage) == stages.end()) {
+		order.push_back(stage);
+	}
+	stages[stage].samples.push_back(seconds);
+}
+
+/**
+ * Print count, mean, median, 95th percentile and maximum of every stage in milliseconds
+ */
+void Profiler::report(std::ostream& out) {
+	out << std::left << std::setw(16) << "stage" << std::right
+		<< std::setw(8) << "count" << std::setw(10) << "mean ms" << std::setw(10) << "p50 ms"
+		<< std::setw(10) << "p95 ms" << std::setw(10) << "max ms" << std::endl;
+	out << std::fixed << std::setprecision(3);
+	for(unsigned int i = 0; i < order.size(); i++) {
+		std::vector<double> samples = stages[order[i]].samples;
+		if(samples.empty()) {
+			continue;
+		}
+		std::sort(samples.begin(), samples.end());
+		double sum = 0;
+		for(unsigned int j = 0; j < samples.size(); j++) {
+			sum += samples[j];
+		}
+		out << std::left << std::setw(16) << order[i] << std::right
+			<< std::setw(8) << samples.size()
+			<< std::setw(10) << sum / samples.size() * 1000
+			<< std::setw(10) << samples[samples.size() / 2] * 1000
+			<< std::setw(10) << samples[(samples.size() * 95) / 100] * 1000
+			<< std::setw(10) << samples.back() * 1000 << std::endl;
+	}
+}
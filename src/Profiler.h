@@ -0,0 +1,57 @@
+/*
+ * Profiler.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+
+/**
+ * Collects per frame timings of the named stages of the tracking pipeline and reports
+ * their distribution. A disabled profiler ignores every call, so the timing calls can
+ * stay in the main loop at no cost outside of benchmark runs.
+ */
+class Profiler {
+
+public:
+	Profiler();
+	void setEnabled(bool enabled);
+	bool isEnabled();
+	void begin(const std::string& stage);
+	void end(const std::string& stage);
+	void addSample(const std::string& stage, double seconds);
+	void report(std::ostream& out);
+
+private:
+	struct Stage {
+		double started; //captureTime() of the last begin()
+		std::vector<double> samples; //duration of every measurement in seconds
+	};
+
+	bool enabled;
+	std::map<std::string, Stage> stages;
+	std::vector<std::string> order; //stage names in the order they were first seen
+};
+
+#endif /* PROFILER_H_ */
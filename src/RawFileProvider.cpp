@@ -0,0 +1,185 @@
+/*
+ * RawFileProvider.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RawFileProvider.h"
+#include "Log.h"
+
+#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <boost/thread.hpp>
+#include <boost/lexical_cast.hpp>
+
+RawFileProvider::RawFileProvider() {
+	fd = -1;
+	map = NULL;
+	mapBytes = 0;
+	header = NULL;
+	position = 0;
+	asFastAsPossible = false;
+	replayStart = 0;
+	recordingStart = 0;
+}
+
+RawFileProvider::~RawFileProvider() {
+	stopCapture();
+	close();
+}
+
+/**
+ * Map the recording at path. With asFastAsPossible frames are returned as fast as the
+ * tracker asks for them, otherwise at the pace they were recorded.
+ * Returns false if the file can not be opened or is not a .gbraw recording.
+ * */
+bool RawFileProvider::open(std::string path, bool asFastAsPossible) {
+	close();
+	this->asFastAsPossible = asFastAsPossible;
+	fd = ::open(path.c_str(), O_RDONLY);
+	struct stat info;
+	if(fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(RawFileHeader)) {
+		close();
+		return false;
+	}
+	void* m = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if(m == MAP_FAILED) {
+		close();
+		return false;
+	}
+	map = (uchar*)m;
+	mapBytes = info.st_size;
+	header = (const RawFileHeader*)map;
+	if(!isValidHeader(*header)) {
+		std::cout << "Error: " << path << " is not a raw recording" << std::endl;
+		close();
+		return false;
+	}
+	//divided rather than multiplied so a damaged frame count can not overflow
+	if(header->frameCount > (mapBytes - sizeof(RawFileHeader)) / header->recordBytes) {
+		std::cout << "Error: raw recording " << path << " is truncated" << std::endl;
+		close();
+		return false;
+	}
+	madvise(m, mapBytes, MADV_SEQUENTIAL);
+	position = 0;
+	replayStart = 0;
+	verbosePrint("Raw recording frames = " + boost::lexical_cast<std::string>(header->frameCount));
+	return true;
+}
+
+/**
+ * True if header is from a .gbraw recording of this version and describes records that
+ * hold a whole monochrome 8 bit frame, so frameAt() never reads past a record
+ * */
+bool RawFileProvider::isValidHeader(const RawFileHeader& header) {
+	if(memcmp(header.magic, raw_file_magic, sizeof(raw_file_magic)) != 0 || header.version != raw_file_version) {
+		return false;
+	}
+	if(header.width <= 0 || header.height <= 0 || header.type != CV_8UC1) {
+		return false;
+	}
+	uint64_t frameBytes = (uint64_t)header.width * header.height;
+	return header.frameBytes == frameBytes && header.recordBytes >= sizeof(RawFrameIndex) + frameBytes;
+}
+
+void RawFileProvider::close() {
+	if(map != NULL) {
+		munmap(map, mapBytes);
+	}
+	if(fd >= 0) {
+		::close(fd);
+	}
+	fd = -1;
+	map = NULL;
+	mapBytes = 0;
+	header = NULL;
+}
+
+unsigned long RawFileProvider::getFrameCount() {
+	if(header == NULL) {
+		return 0;
+	}
+	return header->frameCount;
+}
+
+/**
+ * Random access: point frame at recorded frame i without copying. The image stays
+ * valid until the recording is closed. Returns false if there is no frame i.
+ * */
+bool RawFileProvider::frameAt(unsigned long i, Frame& frame) {
+	if(header == NULL || i >= header->frameCount) {
+		return false;
+	}
+	uchar* record = map + sizeof(RawFileHeader) + i * header->recordBytes;
+	const RawFrameIndex* index = (const RawFrameIndex*)record;
+	frame.image = cv::Mat(header->height, header->width, header->type, record + sizeof(RawFrameIndex));
+	frame.sequence = index->sequence;
+	frame.timestamp = index->timestamp;
+	return true;
+}
+
+/**
+ * Continue replaying from frame i
+ * */
+void RawFileProvider::seek(unsigned long i) {
+	position = i;
+	replayStart = 0;
+}
+
+/**
+ * Next frame with the sequence number and timestamp it was recorded with
+ * */
+bool RawFileProvider::grabFrame(Frame& frame) {
+	if(!frameAt(position, frame)) {
+		frame.image = cv::Mat();
+		return false;
+	}
+	position++;
+
+	if(!asFastAsPossible) {
+		double now = captureTime();
+		if(replayStart == 0) {
+			replayStart = now;
+			recordingStart = frame.timestamp;
+		} else {
+			double due = replayStart + (frame.timestamp - recordingStart);
+			if(now < due) {
+				boost::this_thread::sleep(boost::posix_time::microseconds((long)((due - now) * 1e6)));
+			}
+		}
+	}
+	return true;
+}
+
+cv::Mat RawFileProvider::grabImage() {
+	Frame frame;
+	grabFrame(frame);
+	return frame.image;
+}
+
+/**
+ * A recording can always wait for the tracker, so no frame is ever dropped
+ * */
+bool RawFileProvider::isLive() {
+	return false;
+}
@@ -0,0 +1,66 @@
+/*
+ * RawFileProvider.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RAWFILEPROVIDER_H_
+#define RAWFILEPROVIDER_H_
+
+#include "cv.h"
+#include <string>
+
+#include "ImageProvider.h"
+#include "RawFormat.h"
+
+/**
+ * Replays a .gbraw recording made by RawRecorder. The file is memory mapped and frames
+ * are handed out as Mat headers on the mapping, so nothing is decoded or copied.
+ * Frames keep the sequence numbers and timestamps they were recorded with.
+ * Use without startCapture(): a capture thread would only add a copy.
+ */
+class RawFileProvider : public ImageProvider {
+
+public:
+	RawFileProvider();
+	~RawFileProvider();
+	bool open(std::string path, bool asFastAsPossible);
+	void close();
+	cv::Mat grabImage();
+	unsigned long getFrameCount();
+	bool frameAt(unsigned long i, Frame& frame);
+	void seek(unsigned long i);
+
+protected:
+	bool grabFrame(Frame& frame);
+	bool isLive();
+
+private:
+	static bool isValidHeader(const RawFileHeader& header);
+
+	int fd; //file descriptor of the recording, -1 when closed
+	uchar* map; //read only mapping of the whole file
+	size_t mapBytes;
+	const RawFileHeader* header;
+	unsigned long position; //index of the next frame returned by grabFrame()
+	bool asFastAsPossible; //if false frames are delivered at their recorded pace
+	double replayStart; //captureTime() when the first frame was replayed
+	double recordingStart; //recorded timestamp of the first replayed frame
+};
+
+#endif /* RAWFILEPROVIDER_H_ */
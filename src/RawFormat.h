@@ -0,0 +1,53 @@
+/*
+ * RawFormat.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RAWFORMAT_H_
+#define RAWFORMAT_H_
+
+#include <stdint.h>
+
+/**
+ * Layout of a .gbraw recording: one RawFileHeader followed by fixed size records.
+ * Every record is a RawFrameIndex immediately followed by the uncompressed rows of
+ * the frame, padded to raw_record_alignment, so frame i is at a fixed offset:
+ * sizeof(RawFileHeader) + i * recordBytes.
+ */
+const char raw_file_magic[8] = {'G', 'B', 'R', 'A', 'W', 0, 0, 1};
+const uint32_t raw_file_version = 1;
+const uint64_t raw_record_alignment = 64;
+
+struct RawFileHeader {
+	char magic[8];
+	uint32_t version;
+	int32_t width;
+	int32_t height;
+	int32_t type; //OpenCV type of the frames, e.g. CV_8UC1
+	uint64_t frameBytes; //size of the pixels of one frame, without padding
+	uint64_t recordBytes; //size of one index entry plus frame, including padding
+	uint64_t frameCount; //number of complete records, updated after every frame
+};
+
+struct RawFrameIndex {
+	uint64_t sequence; //sequence number of the frame in the capture stream
+	double timestamp; //capture time in seconds as returned by captureTime()
+};
+
+#endif /* RAWFORMAT_H_ */
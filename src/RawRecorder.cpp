@@ -0,0 +1,172 @@
+/*
+ * RawRecorder.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RawRecorder.h"
+#include "Log.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+RawRecorder::RawRecorder() {
+	fd = -1;
+	map = NULL;
+	mapBytes = 0;
+	capacity = 0;
+	chunkFrames = 0;
+	header = NULL;
+	type = 0;
+}
+
+RawRecorder::~RawRecorder() {
+	close();
+}
+
+/**
+ * Create the recording at path for frames of the given size and type, replacing any
+ * existing file. Disk space for expectedFrames is allocated here, growing the file while
+ * recording stalls the caller. Returns false if the file could not be created.
+ * */
+bool RawRecorder::open(std::string path, cv::Size size, int type, uint64_t expectedFrames) {
+	close();
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) {
+		std::cout << "Error: could not create raw recording " << path << std::endl;
+		return false;
+	}
+	this->size = size;
+	this->type = type;
+	chunkFrames = std::max(expectedFrames, (uint64_t)1);
+	if(!reserve(chunkFrames)) {
+		close();
+		return false;
+	}
+	memcpy(header->magic, raw_file_magic, sizeof(raw_file_magic));
+	header->version = raw_file_version;
+	header->width = size.width;
+	header->height = size.height;
+	header->type = type;
+	header->frameBytes = (uint64_t)size.width * size.height * CV_ELEM_SIZE(type);
+	header->recordBytes = (sizeof(RawFrameIndex) + header->frameBytes + raw_record_alignment - 1) / raw_record_alignment * raw_record_alignment;
+	header->frameCount = 0;
+	verbosePrint("Recording raw frames to " + path);
+	return true;
+}
+
+/**
+ * Grow the file to hold frames records and map it again. The disk space is allocated
+ * up front so the copy in append() does not wait for the file system.
+ * */
+bool RawRecorder::reserve(uint64_t frames) {
+	uint64_t frameBytes = (uint64_t)size.width * size.height * CV_ELEM_SIZE(type);
+	uint64_t recordBytes = (sizeof(RawFrameIndex) + frameBytes + raw_record_alignment - 1) / raw_record_alignment * raw_record_alignment;
+	uint64_t bytes = sizeof(RawFileHeader) + frames * recordBytes;
+	if(posix_fallocate(fd, 0, bytes) != 0 && ftruncate(fd, bytes) != 0) {
+		std::cout << "Error: could not grow raw recording to " << bytes << " bytes" << std::endl;
+		return false;
+	}
+	if(map != NULL) {
+		munmap(map, mapBytes);
+	}
+	void* m = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(m == MAP_FAILED) {
+		std::cout << "Error: could not map raw recording" << std::endl;
+		map = NULL;
+		header = NULL;
+		return false;
+	}
+	madvise(m, bytes, MADV_SEQUENTIAL);
+	map = (uchar*)m;
+	mapBytes = bytes;
+	capacity = frames;
+	header = (RawFileHeader*)map;
+	return true;
+}
+
+/**
+ * Copy image to the end of the recording together with its place in the capture stream.
+ * Returns false if the recording is closed or image does not match its size and type.
+ * */
+bool RawRecorder::append(const cv::Mat& image, unsigned long sequence, double timestamp) {
+	if(header == NULL || image.size() != size || image.type() != type) {
+		return false;
+	}
+	if(header->frameCount == capacity && !reserve(capacity + chunkFrames)) {
+		return false;
+	}
+	uchar* record = map + sizeof(RawFileHeader) + header->frameCount * header->recordBytes;
+	RawFrameIndex* index = (RawFrameIndex*)record;
+	index->sequence = sequence;
+	index->timestamp = timestamp;
+
+	//camera frames are usually a ROI of a larger image, so copy row by row
+	uchar* pixels = record + sizeof(RawFrameIndex);
+	size_t rowBytes = size.width * image.elemSize();
+	if(image.isContinuous()) {
+		memcpy(pixels, image.data, header->frameBytes);
+	} else {
+		for(int y = 0; y < size.height; y++) {
+			memcpy(pixels + y * rowBytes, image.ptr(y), rowBytes);
+		}
+	}
+	//count the frame last so a crash never leaves a counted frame half written
+	header->frameCount++;
+	return true;
+}
+
+/**
+ * Trim the preallocated space that was not used and close the file
+ * */
+void RawRecorder::close() {
+	if(fd < 0) {
+		return;
+	}
+	uint64_t used = 0;
+	if(header != NULL) {
+		used = sizeof(RawFileHeader) + header->frameCount * header->recordBytes;
+	}
+	if(map != NULL) {
+		munmap(map, mapBytes);
+	}
+	if(ftruncate(fd, used) != 0) {
+		std::cout << "Error: could not trim raw recording" << std::endl;
+	}
+	::close(fd);
+	fd = -1;
+	map = NULL;
+	header = NULL;
+	mapBytes = 0;
+	capacity = 0;
+}
+
+bool RawRecorder::isOpen() {
+	return header != NULL;
+}
+
+unsigned long RawRecorder::getFrameCount() {
+	if(header == NULL) {
+		return 0;
+	}
+	return header->frameCount;
+}
@@ -0,0 +1,62 @@
+/*
+ * RawRecorder.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RAWRECORDER_H_
+#define RAWRECORDER_H_
+
+#include "cv.h"
+#include <string>
+
+#include "RawFormat.h"
+
+/**
+ * Appends frames to a memory mapped .gbraw file. The file is allocated and mapped for
+ * the expected number of frames when it is opened, so recording a frame is only a copy
+ * into the mapping. Longer recordings grow the file by the same amount at a time.
+ */
+class RawRecorder {
+
+public:
+	RawRecorder();
+	~RawRecorder();
+	bool open(std::string path, cv::Size size, int type, uint64_t expectedFrames);
+	bool append(const cv::Mat& image, unsigned long sequence, double timestamp);
+	void close();
+	bool isOpen();
+	unsigned long getFrameCount();
+
+private:
+	bool reserve(uint64_t frames);
+
+	int fd; //file descriptor of the recording, -1 when closed
+	uchar* map; //mapping of the whole preallocated file
+	uint64_t mapBytes; //size of the mapping and of the file on disk
+	uint64_t capacity; //number of records that fit in the preallocated file
+	uint64_t chunkFrames; //number of records the file is grown by when it is full
+	RawFileHeader* header; //header at the start of the mapping
+	cv::Size size;
+	int type;
+
+	RawRecorder(const RawRecorder&); //Prevent copy-construction
+	RawRecorder& operator=(const RawRecorder&); //Prevent assignment
+};
+
+#endif /* RAWRECORDER_H_ */
@@ -52,6 +52,8 @@ bool Setting::loadOptions(int argc, char* argv[]) {
 		   ("help", "Display this message")
 		   ("pgr-index", po::value<int>(&pgr_cam_index)->default_value(0), "index of pgr camera to use. Negative means do not use pgr camera")
 		   ("obs-cam-index", po::value<int>(&pgr_obs_cam1_index)->default_value(1), "index of observer camera")
+		   ("obs-cam-fps", po::value<float>(&obs_cam_fps)->default_value(10), "frame rate of the observer camera, which is only used for display and recording")
+		   ("obs-cam-scale", po::value<float>(&obs_cam_scale)->default_value(1), "scale factor applied to observer frames, e.g. 0.5 for half size")
 		   ("pgr-cam-max-width", po::value<int>(&pgr_cam_max_width)->default_value(752), "max width of camera")
 		   ("pgr-cam-max-height", po::value<int>(&pgr_cam_max_height)->default_value(480), "max height of camera")
 		   ("participant-number", po::value<std::string>(&participant_number), "user study participant number")
@@ -61,22 +63,54 @@ bool Setting::loadOptions(int argc, char* argv[]) {
 		   ("send-tuio", po::value<bool>(&send_tuio), "if true gestures are sent as tuio messages")
 		   ("tuio-port", po::value<int>(&tuio_port), "Port to be used to deliver TUIO messages")
 		   ("tuio-host", po::value<string>(&tuio_host), "Host for TUIO messages to go to")
-		   ("source-recording-path", po::value<std::string>(&source_recording_path), "The path where video from camera will be saved without visualizations or annotation.")
+		   ("source-recording-path", po::value<std::string>(&source_recording_path), "The path where video from camera will be saved without visualizations or annotation. A path ending in .gbraw records uncompressed frames with their timestamps")
 		   ("result-recording-path", po::value<std::string>(&result_recording_path), "The path where annotated video with visualization of features and detecte gestures will be stored")
 		   ("log-path", po::value<std::string>(&log_path), "The path for log file of detected gestures")
 		   ("snapshot-path", po::value<std::string>(&snapshot_path), "The path to save snapshots of important images")
-		   ("input-video-path", po::value<std::string>(&input_video_path),"Path to the input video to use instead of the camera")
+		   ("input-video-path", po::value<std::string>(&input_video_path),"Path to the input video to use instead of the camera, either a video file or a .gbraw raw recording")
+		   ("video-replay-mode", po::value<std::string>(&video_replay_mode)->default_value("realtime"), "realtime: replay input video at its recorded frame rate, fast: replay it as fast as it can be tracked")
+		   ("synthetic-input", po::value<bool>(&synthetic_input)->default_value(false), "if true and there is no pgr camera, track a synthetic hand scene instead of the input video")
+		   ("synthetic-seed", po::value<int>(&synthetic_seed)->default_value(1), "seed of the synthetic scene, the same seed always renders the same frames")
+		   ("synthetic-hands", po::value<int>(&synthetic_hands)->default_value(2), "number of hands in the synthetic scene (1 or 2)")
+		   ("synthetic-blur", po::value<float>(&synthetic_blur)->default_value(1.5), "sigma of the gaussian blur of the synthetic scene, 0 for a sharp image")
+		   ("synthetic-noise", po::value<float>(&synthetic_noise)->default_value(4), "sigma of the noise added to the synthetic scene in gray levels")
+		   ("synthetic-width", po::value<int>(&synthetic_width)->default_value(665), "width of the synthetic scene")
+		   ("synthetic-height", po::value<int>(&synthetic_height)->default_value(374), "height of the synthetic scene")
+		   ("synthetic-fps", po::value<float>(&synthetic_fps)->default_value(0), "frame rate of the synthetic scene, 0 to render as fast as it is tracked")
+		   ("benchmark-frames", po::value<int>(&benchmark_frames)->default_value(0), "if positive, stop after this many frames and print the time spent in each stage of the pipeline")
+		   ("sharpness-kernel", po::value<std::string>(&sharpness_kernel)->default_value("fused"), "fused: compute the touch image in one vectorized pass, opencv: use cornerMinEigenVal")
+		   ("self-test", po::value<bool>(&self_test)->default_value(false), "compare the image kernels with the OpenCV functions they replace, print the results and exit, non-zero on a difference")
 		   ("lower-threshold", po::value<int>(&lower_threshold)->default_value(10), "Set the lower threshold")
 		   ("upper-threshold", po::value<int>(&upper_threshold)->default_value(255), "set the upper threshold")
 		   ("radius-threshold", po::value<int>(&radius_threshold)->default_value(20), "Set the lower threshold")
 		   ("touch-depth-threshold", po::value<int>(&touch_depth_threshold)->default_value(220), "Set depth threshold")
+		   ("min-features-per-hand", po::value<int>(&min_features_per_hand)->default_value(2), "detect new features only when a hand has fewer tracked features than this")
+		   ("lk-max-level", po::value<int>(&lk_max_level)->default_value(1), "coarsest pyramid level of the feature optical flow, raise it for fast hand motion")
+		   ("lk-window-size", po::value<int>(&lk_window_size)->default_value(26), "side of the feature optical flow search window in pixels")
+		   ("lk-min-eig-threshold", po::value<double>(&lk_min_eig_threshold)->default_value(1e-4), "features on too little texture for the optical flow, by minimum eigenvalue, are lost")
+		   ("dense-flow", po::value<bool>(&dense_flow)->default_value(false), "if true, grab and release are detected from dense optical flow over the hands")
+		   ("dense-flow-downscale", po::value<int>(&dense_flow_downscale)->default_value(4), "integer factor the frame is shrunk by for the dense flow")
+		   ("dense-flow-padding", po::value<int>(&dense_flow_padding)->default_value(16), "pixels added around each hand for the dense flow")
+		   ("dense-flow-divergence", po::value<float>(&dense_flow_divergence)->default_value(1.2), "mean dense flow divergence per second that counts as a grab or release")
+		   ("gesture-min-speed", po::value<float>(&gesture_min_speed)->default_value(150), "features slower than this in pixels per second are ignored by grab and release")
+		   ("filter-min-cutoff", po::value<float>(&filter_min_cutoff)->default_value(1), "cutoff frequency in Hz of the hand position filter when the hand is still, lower for less jitter")
+		   ("filter-beta", po::value<float>(&filter_beta)->default_value(0.01), "increase of the hand position filter cutoff per pixel per second of speed, higher for less lag")
+		   ("filter-derivative-cutoff", po::value<float>(&filter_derivative_cutoff)->default_value(1), "cutoff frequency in Hz of the hand speed used by the filter and the prediction")
+		   ("prediction-horizon", po::value<float>(&prediction_horizon)->default_value(0.016), "seconds from sending a hand position to its display, the position is predicted this far past the measured latency")
 		   ("median-blur-factor", po::value<int>(&median_blur_factor)->default_value(7), "set the median blur factor for contour detection")
 		   ("do-undistortion", po::value<bool>(&do_undistortion), "If true, camera image will be corrected for lens distortion")
+		   ("undistortion-mode", po::value<std::string>(&undistortion_mode)->default_value("frame"), "frame: undistort every camera frame, points: keep frames distorted and undistort hand contours and features")
 		   ("undistortion-factor", po::value<float>(&undistortion_factor)->default_value(0.35), "factor for correcting undistortion")
 		   ("imageOffsetX", po::value<float>(&imageOffsetX)->default_value(0), "x offset of image ROI")
 		   ("imageOffsetY", po::value<float>(&imageOffsetY)->default_value(0), "y offset of image ROI")
 		   ("imageSizeX", po::value<float>(&imageSizeX)->default_value(752), "width of image ROI")
 		   ("imageSizeY", po::value<float>(&imageSizeY)->default_value(480), "height of image ROI")
+		   ("frame-ring-size", po::value<int>(&frame_ring_size)->default_value(4), "number of frames buffered between camera capture and processing")
+		   ("frame-policy", po::value<std::string>(&frame_policy)->default_value("latest"), "latest: always process the newest camera frame, every: process every camera frame")
+		   ("worker-threads", po::value<int>(&worker_threads)->default_value(0), "number of threads running the image stages of each frame, 0 for one per core, 1 to run them serially")
+		   ("recording-queue-size", po::value<int>(&recording_queue_size)->default_value(8), "number of frames queued for each video writer thread")
+		   ("recording-overflow-policy", po::value<std::string>(&recording_overflow_policy)->default_value("drop-oldest"), "block: wait for the video writer, drop-oldest: replace the oldest queued frame, drop-newest: discard the new frame")
+		   ("raw-recording-frames", po::value<int>(&raw_recording_frames)->default_value(18000), "frames of disk space a .gbraw recording allocates when it starts, set it to the expected length so the tracking loop never waits for the file to grow")
 		   ("undistortion-calibration-numChessboards", po::value<int>(&undistortion_calibration_numChessboards)->default_value(2), "number of chess boards to use for undistortion calibration")
 		   ("undistortion-calibration-hCorners", po::value<int>(&undistortion_calibration_hCorners)->default_value(6), "number of horizontal inside corners in chess board image used for undistortion calibration")
 		   ("undistortion-calibration-vCorners", po::value<int>(&undistortion_calibration_vCorners)->default_value(6), "number of vertical inside corners in chess board image used for undistortion calibration")
@@ -120,15 +154,43 @@ bool Setting::loadOptions(int argc, char* argv[]) {
 					<< "\nis daemon	= " << is_daemon
 					<< "\nlog path = " << log_path
 					<< "\npgr camera index = " << pgr_cam_index
+					<< "\nobserver camera fps = " << obs_cam_fps
+					<< "\nobserver camera scale = " << obs_cam_scale
 					<< "\nsource recording path	= " << source_recording_path
 					<< "\nresult recording path	= " << result_recording_path
 					<< "\nsnapshot path = " << snapshot_path
 					<< "\ninput video path = " << input_video_path
+					<< "\nvideo replay mode = " << video_replay_mode
 					<< "\nconfig file path = " << config_file_path
+					<< "\nsynthetic input = " << synthetic_input
+					<< "\nsynthetic seed = " << synthetic_seed
+					<< "\nbenchmark frames = " << benchmark_frames
+					<< "\nsharpness kernel = " << sharpness_kernel
+					<< "\nself test = " << self_test
 					<< "\nlower threshold = " << lower_threshold
 					<< "\nupper threshold = "	<< upper_threshold
 					<< "\nmedian blur factor = " << median_blur_factor
+					<< "\nmin features per hand = " << min_features_per_hand
+					<< "\nlk max level = " << lk_max_level
+					<< "\nlk window size = " << lk_window_size
+					<< "\nlk min eig threshold = " << lk_min_eig_threshold
+					<< "\ndense flow = " << dense_flow
+					<< "\ndense flow downscale = " << dense_flow_downscale
+					<< "\ndense flow padding = " << dense_flow_padding
+					<< "\ndense flow divergence = " << dense_flow_divergence
+					<< "\ngesture min speed = " << gesture_min_speed
+					<< "\nfilter min cutoff = " << filter_min_cutoff
+					<< "\nfilter beta = " << filter_beta
+					<< "\nfilter derivative cutoff = " << filter_derivative_cutoff
+					<< "\nprediction horizon = " << prediction_horizon
 					<< "\ndo undistortion = " << do_undistortion
+					<< "\nundistortion mode = " << undistortion_mode
+					<< "\nframe ring size = " << frame_ring_size
+					<< "\nframe policy = " << frame_policy
+					<< "\nworker threads = " << worker_threads
+					<< "\nrecording queue size = " << recording_queue_size
+					<< "\nrecording overflow policy = " << recording_overflow_policy
+					<< "\nraw recording frames = " << raw_recording_frames
 					<< "\n*******************************************************"
 					<< endl;
 		}
@@ -55,6 +55,19 @@ public:
 	int upper_threshold;
 	int radius_threshold; //how big blobs should be to be considered as a hand
 	int touch_depth_threshold; //how close finger should be to be considered touch. Lower value means higher sensitivity
+	int min_features_per_hand; //new features are only detected when a hand has fewer tracked features than this
+	int lk_max_level; //coarsest pyramid level of the optical flow, 0 for a single level
+	int lk_window_size; //side of the optical flow search window in pixels
+	double lk_min_eig_threshold; //features whose optical flow matrix has a smaller minimum eigenvalue are lost
+	bool dense_flow; //detect grab and release from dense optical flow over the hands instead of the tracked features
+	int dense_flow_downscale; //the frame is shrunk by this factor before the dense flow is computed
+	int dense_flow_padding; //pixels added around each hand for the dense flow
+	float dense_flow_divergence; //mean flow divergence per second that counts as a grab (negative) or release (positive)
+	float gesture_min_speed; //features slower than this in pixels per second do not take part in grab and release
+	float filter_min_cutoff; //cutoff frequency in Hz of the hand position filter when the hand is still
+	float filter_beta; //increase of the cutoff frequency in Hz per pixel per second of hand speed
+	float filter_derivative_cutoff; //cutoff frequency in Hz of the filtered hand speed
+	float prediction_horizon; //seconds from the end of processing to display, added to the measured latency for prediction
 	int median_blur_factor;
 	bool save_input_video;
 	bool save_output_video;
@@ -67,12 +80,25 @@ public:
 	string snapshot_path;
 	string log_path;
 	string input_video_path;
+	string video_replay_mode; //"realtime" replays input video at its recorded frame rate, "fast" as fast as it can be tracked
 	string config_file_path;
+	bool synthetic_input; //render a synthetic hand scene instead of reading input-video-path when there is no pgr camera
+	int synthetic_seed; //every frame of the synthetic scene is a function of this seed and the frame number
+	int synthetic_hands; //number of hands in the synthetic scene, 1 or 2
+	float synthetic_blur; //sigma of the gaussian blur applied to the synthetic scene, 0 for none
+	float synthetic_noise; //sigma of the sensor noise added to the synthetic scene in gray levels
+	int synthetic_width;
+	int synthetic_height;
+	float synthetic_fps; //frame rate of the synthetic scene, 0 to render as fast as it is tracked
+	int benchmark_frames; //when positive, stop after this many frames and print a timing report of the pipeline
+	string sharpness_kernel; //"fused" computes the touch image with SharpnessKernel, "opencv" with cornerMinEigenVal
+	bool self_test; //compare the image kernels with the OpenCV functions they replace and exit
 	int grab_std_dev_factor; // the rate at which stdDev is expected to change during grab and release gesture
 	int tuio_port;
 	string tuio_host;
 	float undistortion_factor; //alpha factor for correcting image distortion. Should be in the range: [0 1] inclusive.
 	bool do_undistortion;
+	string undistortion_mode; //"frame" undistorts every camera frame, "points" only undistorts tracked coordinates
 
 	/*** modes ***/
 	bool left_grab_mode;
@@ -82,12 +108,20 @@ public:
 	/*** pgr camera settings ***/
 	int pgr_cam_index;
 	int pgr_obs_cam1_index;
+	float obs_cam_fps; //frame rate of the observer camera, independent of the tracking camera
+	float obs_cam_scale; //observer frames are downscaled by this factor on its capture thread, 1 for full size
 	int pgr_cam_max_width;
 	int pgr_cam_max_height;
 	float imageOffsetX; //offset of image ROI
 	float imageOffsetY;
 	float imageSizeX; //size of the image after ROI selection
 	float imageSizeY;
+	int frame_ring_size; //number of preallocated frames between the capture thread and processing
+	string frame_policy; //"latest" to always process the newest frame, "every" to process all frames
+	int worker_threads; //threads running the image stages of a frame, 0 for one per core
+	int recording_queue_size; //number of frames waiting for each video writer thread
+	string recording_overflow_policy; //"block", "drop-oldest" or "drop-newest" when a video writer falls behind
+	int raw_recording_frames; //frames of disk space a .gbraw recording allocates up front and grows by when full
 
 	/*** undistortion calibration camera settings ***/
 	int undistortion_calibration_numChessboards;
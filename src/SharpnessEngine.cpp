@@ -0,0 +1,144 @@
+/*
+ * SharpnessEngine.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SharpnessEngine.h"
+
+#include <algorithm>
+
+using namespace cv;
+
+//a band of a tile needs block size extra covariance rows, so bands are kept well above that
+static const int min_band_rows = 2 * sharpness_block_size;
+
+SharpnessEngine::SharpnessEngine() : eigenTiles(1), kernels(1) {
+	current = 0;
+	source = NULL;
+	fused = true;
+	pool = NULL;
+}
+
+/**
+ * Choose between the fused kernel and cornerMinEigenVal followed by convertTo
+ */
+void SharpnessEngine::useFusedKernel(bool fused) {
+	this->fused = fused;
+}
+
+const char* SharpnessEngine::getKernelName() {
+	return fused ? kernels[0].getInstructionSet() : "opencv";
+}
+
+/**
+ * Compute the tiles on pool, or on the calling thread if pool is NULL
+ */
+void SharpnessEngine::setWorkerPool(WorkerPool* pool) {
+	this->pool = pool;
+	int threads = pool != NULL ? pool->getThreadCount() : 1;
+	eigenTiles.resize(threads);
+	kernels.resize(threads);
+}
+
+/**
+ * Return the touch image of source computed inside regions (usually the bounding
+ * rectangles of the hands). The returned image is valid until compute() is called twice more.
+ */
+Mat SharpnessEngine::compute(const Mat& source, const std::vector<Rect>& regions) {
+	current = 1 - current;
+	Mat& output = outputs[current];
+	if(output.size() != source.size()) {
+		output.create(source.size(), CV_8UC1);
+		output.setTo(Scalar(0));
+		written[current].clear();
+	}
+
+	//only the tiles of two frames ago have to be cleared, not the whole image
+	for(unsigned int i = 0; i < written[current].size(); i++) {
+		output(written[current][i]).setTo(Scalar(0));
+	}
+	written[current].clear();
+
+	Rect frame(0, 0, source.cols, source.rows);
+	std::vector<Rect> tiles;
+	for(unsigned int i = 0; i < regions.size(); i++) {
+		Rect tile(regions[i].x - sharpness_kernel_radius, regions[i].y - sharpness_kernel_radius,
+				regions[i].width + 2 * sharpness_kernel_radius, regions[i].height + 2 * sharpness_kernel_radius);
+		tile &= frame;
+		if(tile.area() == 0) {
+			continue;
+		}
+		//hands close to each other share one tile so no pixel is computed twice
+		bool merged = false;
+		for(unsigned int j = 0; j < tiles.size(); j++) {
+			if((tiles[j] & tile).area() > 0) {
+				tiles[j] |= tile;
+				merged = true;
+				break;
+			}
+		}
+		if(!merged) {
+			tiles.push_back(tile);
+		}
+	}
+
+	//split the tiles into bands so that all the workers get a share of a large hand
+	int threads = pool != NULL ? pool->getThreadCount() : 1;
+	bands.clear();
+	for(unsigned int i = 0; i < tiles.size(); i++) {
+		int count = std::max(1, std::min(threads, tiles[i].height / min_band_rows));
+		for(int b = 0; b < count; b++) {
+			int y0 = tiles[i].height * b / count, y1 = tiles[i].height * (b + 1) / count;
+			bands.push_back(Rect(tiles[i].x, tiles[i].y + y0, tiles[i].width, y1 - y0));
+		}
+		written[current].push_back(tiles[i]);
+	}
+
+	this->source = &source;
+	if(pool != NULL) {
+		pool->run(*this, bands.size());
+	} else {
+		for(unsigned int i = 0; i < bands.size(); i++) {
+			run(i, 0);
+		}
+	}
+	this->source = NULL;
+	return output;
+}
+
+/**
+ * Compute band index of the current frame with the buffers of worker
+ */
+void SharpnessEngine::run(int index, int worker) {
+	const Rect& band = bands[index];
+	Mat outputTile = outputs[current](band);
+	if(fused) {
+		//the kernel reads around the band itself and reflects at the frame border
+		kernels[worker].compute(*source, band, outputTile);
+		return;
+	}
+	//the input needs another kernel radius around the band for exact values at its edge
+	Rect frame(0, 0, source->cols, source->rows);
+	Rect input(band.x - sharpness_kernel_radius, band.y - sharpness_kernel_radius,
+			band.width + 2 * sharpness_kernel_radius, band.height + 2 * sharpness_kernel_radius);
+	input &= frame;
+	cornerMinEigenVal((*source)(input), eigenTiles[worker], sharpness_block_size, sharpness_aperture_size);
+	Rect inside(band.x - input.x, band.y - input.y, band.width, band.height);
+	eigenTiles[worker](inside).convertTo(outputTile, CV_8UC1, sharpness_scale, 0);
+}
@@ -0,0 +1,60 @@
+/*
+ * SharpnessEngine.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHARPNESSENGINE_H_
+#define SHARPNESSENGINE_H_
+
+#include "cv.h"
+#include "SharpnessKernel.h"
+#include "WorkerPool.h"
+#include <vector>
+
+/**
+ * Computes the 8 bit touch (sharpness) image only around the hands. Each hand region
+ * is padded by the kernel radius, so the result inside the padded region matches a
+ * full frame computation, and everything outside reads as zero.
+ * Two output buffers are used in turn so the image of the previous frame stays valid.
+ * Tiles are computed by the fused SharpnessKernel unless OpenCV is requested, in bands
+ * spread over a WorkerPool when one is set.
+ */
+class SharpnessEngine : public WorkerTask {
+
+public:
+	SharpnessEngine();
+	cv::Mat compute(const cv::Mat& source, const std::vector<cv::Rect>& regions);
+	void useFusedKernel(bool fused);
+	const char* getKernelName();
+	void setWorkerPool(WorkerPool* pool);
+	void run(int index, int worker);
+
+private:
+	cv::Mat outputs[2]; //touch images of the last two frames
+	std::vector<cv::Rect> written[2]; //tiles written into each output, cleared before reuse
+	int current; //output written by the last compute()
+	std::vector<cv::Rect> bands; //parts of the tiles of the current frame computed by one task each
+	const cv::Mat* source; //frame of the current compute()
+	std::vector<cv::Mat> eigenTiles; //minimum eigenvalues of one band per worker, OpenCV path only
+	std::vector<SharpnessKernel> kernels; //one per worker, they keep row buffers
+	bool fused; //use kernel instead of cornerMinEigenVal
+	WorkerPool* pool; //NULL to compute every band on the calling thread
+};
+
+#endif /* SHARPNESSENGINE_H_ */
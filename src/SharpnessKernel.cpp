@@ -0,0 +1,485 @@
+/*
+ * SharpnessKernel.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SharpnessKernel.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <iomanip>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHARPNESS_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace cv;
+
+//Sobel kernels of aperture 9 as built by getDerivKernels(): smoothing and first derivative
+static const float smooth_kernel[9] = {1, 8, 28, 56, 70, 56, 28, 8, 1};
+static const float deriv_kernel[9] = {-1, -6, -14, -14, 0, 14, 14, 6, 1};
+static const int aperture_radius = sharpness_aperture_size / 2;
+//box filter of the covariance covers [-box_before, box_after] around each pixel, like boxFilter() with the default anchor
+static const int box_before = sharpness_block_size / 2;
+static const int box_after = sharpness_block_size - 1 - box_before;
+//scale cornerMinEigenVal applies to 8 bit derivatives: 1 / (2^(aperture - 1) * block size * 255)
+static const double derivative_scale = 1.0 / ((1 << (sharpness_aperture_size - 1)) * sharpness_block_size * 255.0);
+//factor from the covariance sums to the halved diagonal terms of the matrix in output units
+static const double eigen_scale = derivative_scale * derivative_scale * sharpness_scale;
+
+/**
+ * BORDER_REFLECT_101 index, as used by cornerMinEigenVal
+ */
+static inline int reflect101(int p, int n) {
+	while(p < 0 || p >= n) {
+		p = p < 0 ? -p : 2 * n - 2 - p;
+	}
+	return p;
+}
+
+/**
+ * Minimum eigenvalue of the covariance sums in output units, clamped to [0, 255]
+ */
+static inline double minEigen(double sxx, double sxy, double syy) {
+	double a = sxx * (0.5 * eigen_scale);
+	double b = sxy * eigen_scale;
+	double c = syy * (0.5 * eigen_scale);
+	double l = (a + c) - std::sqrt((a - c) * (a - c) + b * b);
+	return std::min(std::max(l, 0.0), 255.0);
+}
+
+/*** portable passes ***/
+
+static void verticalScalar(const uchar* const* rows, int n, float* smooth, float* deriv) {
+	for(int i = 0; i < n; i++) {
+		float s = 0, d = 0;
+		for(int t = 0; t < sharpness_aperture_size; t++) {
+			float v = rows[t][i];
+			s += smooth_kernel[t] * v;
+			d += deriv_kernel[t] * v;
+		}
+		smooth[i] = s;
+		deriv[i] = d;
+	}
+}
+
+static void horizontalScalar(const float* smooth, const float* deriv, int n, float* dx, float* dy) {
+	for(int i = 0; i < n; i++) {
+		float x = 0, y = 0;
+		for(int t = 0; t < sharpness_aperture_size; t++) {
+			x += deriv_kernel[t] * smooth[i + t];
+			y += smooth_kernel[t] * deriv[i + t];
+		}
+		dx[i] = x;
+		dy[i] = y;
+	}
+}
+
+/**
+ * Replace the oldest covariance row in ring with the products of dx and dy and keep the
+ * column sums up to date. ring and sums hold the xx, xy and yy planes n apart.
+ */
+static void covarianceScalar(const float* dx, const float* dy, int n, double* ring, double* sums) {
+	for(int i = 0; i < n; i++) {
+		double x = dx[i], y = dy[i];
+		double xx = x * x, xy = x * y, yy = y * y;
+		sums[i] += xx - ring[i];
+		sums[i + n] += xy - ring[i + n];
+		sums[i + 2 * n] += yy - ring[i + 2 * n];
+		ring[i] = xx;
+		ring[i + n] = xy;
+		ring[i + 2 * n] = yy;
+	}
+}
+
+/**
+ * Box sums from the prefix sums of the three planes, stride apart, then the
+ * minimum eigenvalue rounded to 8 bit like convertTo()
+ */
+static void eigenScalar(const double* prefix, int stride, int n, uchar* dst) {
+	for(int j = 0; j < n; j++) {
+		double sxx = prefix[j + sharpness_block_size] - prefix[j];
+		double sxy = prefix[stride + j + sharpness_block_size] - prefix[stride + j];
+		double syy = prefix[2 * stride + j + sharpness_block_size] - prefix[2 * stride + j];
+		dst[j] = (uchar)cvRound(minEigen(sxx, sxy, syy));
+	}
+}
+
+#ifdef SHARPNESS_X86
+
+/*** SSE4.1 passes ***/
+
+__attribute__((target("sse4.1")))
+static void verticalSSE41(const uchar* const* rows, int n, float* smooth, float* deriv) {
+	int i = 0;
+	for(; i + 4 <= n; i += 4) {
+		__m128 s = _mm_setzero_ps(), d = _mm_setzero_ps();
+		for(int t = 0; t < sharpness_aperture_size; t++) {
+			int packed;
+			memcpy(&packed, rows[t] + i, sizeof(packed));
+			__m128 v = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+			s = _mm_add_ps(s, _mm_mul_ps(_mm_set1_ps(smooth_kernel[t]), v));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(deriv_kernel[t]), v));
+		}
+		_mm_storeu_ps(smooth + i, s);
+		_mm_storeu_ps(deriv + i, d);
+	}
+	const uchar* tail[sharpness_aperture_size];
+	for(int t = 0; t < sharpness_aperture_size; t++) {
+		tail[t] = rows[t] + i;
+	}
+	verticalScalar(tail, n - i, smooth + i, deriv + i);
+}
+
+__attribute__((target("sse4.1")))
+static void horizontalSSE41(const float* smooth, const float* deriv, int n, float* dx, float* dy) {
+	int i = 0;
+	for(; i + 4 <= n; i += 4) {
+		__m128 x = _mm_setzero_ps(), y = _mm_setzero_ps();
+		for(int t = 0; t < sharpness_aperture_size; t++) {
+			x = _mm_add_ps(x, _mm_mul_ps(_mm_set1_ps(deriv_kernel[t]), _mm_loadu_ps(smooth + i + t)));
+			y = _mm_add_ps(y, _mm_mul_ps(_mm_set1_ps(smooth_kernel[t]), _mm_loadu_ps(deriv + i + t)));
+		}
+		_mm_storeu_ps(dx + i, x);
+		_mm_storeu_ps(dy + i, y);
+	}
+	horizontalScalar(smooth + i, deriv + i, n - i, dx + i, dy + i);
+}
+
+__attribute__((target("sse4.1")))
+static void covarianceSSE41(const float* dx, const float* dy, int n, double* ring, double* sums) {
+	int i = 0;
+	for(; i + 2 <= n; i += 2) {
+		__m128d x = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)(dx + i))));
+		__m128d y = _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)(dy + i))));
+		__m128d products[3] = {_mm_mul_pd(x, x), _mm_mul_pd(x, y), _mm_mul_pd(y, y)};
+		for(int p = 0; p < 3; p++) {
+			double* r = ring + p * n + i;
+			double* s = sums + p * n + i;
+			_mm_storeu_pd(s, _mm_add_pd(_mm_loadu_pd(s), _mm_sub_pd(products[p], _mm_loadu_pd(r))));
+			_mm_storeu_pd(r, products[p]);
+		}
+	}
+	for(; i < n; i++) {
+		double x = dx[i], y = dy[i];
+		double products[3] = {x * x, x * y, y * y};
+		for(int p = 0; p < 3; p++) {
+			sums[p * n + i] += products[p] - ring[p * n + i];
+			ring[p * n + i] = products[p];
+		}
+	}
+}
+
+__attribute__((target("sse4.1")))
+static void eigenSSE41(const double* prefix, int stride, int n, uchar* dst) {
+	const __m128d half = _mm_set1_pd(0.5 * eigen_scale), full = _mm_set1_pd(eigen_scale);
+	const __m128d zero = _mm_setzero_pd(), top = _mm_set1_pd(255);
+	int j = 0;
+	for(; j + 2 <= n; j += 2) {
+		const double* p = prefix + j;
+		__m128d a = _mm_mul_pd(half, _mm_sub_pd(_mm_loadu_pd(p + sharpness_block_size), _mm_loadu_pd(p)));
+		p += stride;
+		__m128d b = _mm_mul_pd(full, _mm_sub_pd(_mm_loadu_pd(p + sharpness_block_size), _mm_loadu_pd(p)));
+		p += stride;
+		__m128d c = _mm_mul_pd(half, _mm_sub_pd(_mm_loadu_pd(p + sharpness_block_size), _mm_loadu_pd(p)));
+		__m128d amc = _mm_sub_pd(a, c);
+		__m128d l = _mm_sub_pd(_mm_add_pd(a, c), _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(amc, amc), _mm_mul_pd(b, b))));
+		l = _mm_min_pd(_mm_max_pd(l, zero), top);
+		__m128i v = _mm_cvtpd_epi32(l);
+		v = _mm_packus_epi16(_mm_packs_epi32(v, v), v);
+		short pair = (short)_mm_extract_epi16(v, 0);
+		memcpy(dst + j, &pair, 2);
+	}
+	eigenScalar(prefix + j, stride, n - j, dst + j);
+}
+
+/*** AVX2 passes ***/
+
+__attribute__((target("avx2")))
+static void verticalAVX2(const uchar* const* rows, int n, float* smooth, float* deriv) {
+	int i = 0;
+	for(; i + 8 <= n; i += 8) {
+		__m256 s = _mm256_setzero_ps(), d = _mm256_setzero_ps();
+		for(int t = 0; t < sharpness_aperture_size; t++) {
+			__m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(rows[t] + i))));
+			s = _mm256_add_ps(s, _mm256_mul_ps(_mm256_set1_ps(smooth_kernel[t]), v));
+			d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(deriv_kernel[t]), v));
+		}
+		_mm256_storeu_ps(smooth + i, s);
+		_mm256_storeu_ps(deriv + i, d);
+	}
+	const uchar* tail[sharpness_aperture_size];
+	for(int t = 0; t < sharpness_aperture_size; t++) {
+		tail[t] = rows[t] + i;
+	}
+	verticalScalar(tail, n - i, smooth + i, deriv + i);
+}
+
+__attribute__((target("avx2")))
+static void horizontalAVX2(const float* smooth, const float* deriv, int n, float* dx, float* dy) {
+	int i = 0;
+	for(; i + 8 <= n; i += 8) {
+		__m256 x = _mm256_setzero_ps(), y = _mm256_setzero_ps();
+		for(int t = 0; t < sharpness_aperture_size; t++) {
+			x = _mm256_add_ps(x, _mm256_mul_ps(_mm256_set1_ps(deriv_kernel[t]), _mm256_loadu_ps(smooth + i + t)));
+			y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_set1_ps(smooth_kernel[t]), _mm256_loadu_ps(deriv + i + t)));
+		}
+		_mm256_storeu_ps(dx + i, x);
+		_mm256_storeu_ps(dy + i, y);
+	}
+	horizontalScalar(smooth + i, deriv + i, n - i, dx + i, dy + i);
+}
+
+__attribute__((target("avx2")))
+static void covarianceAVX2(const float* dx, const float* dy, int n, double* ring, double* sums) {
+	int i = 0;
+	for(; i + 4 <= n; i += 4) {
+		__m256d x = _mm256_cvtps_pd(_mm_loadu_ps(dx + i));
+		__m256d y = _mm256_cvtps_pd(_mm_loadu_ps(dy + i));
+		__m256d products[3] = {_mm256_mul_pd(x, x), _mm256_mul_pd(x, y), _mm256_mul_pd(y, y)};
+		for(int p = 0; p < 3; p++) {
+			double* r = ring + p * n + i;
+			double* s = sums + p * n + i;
+			_mm256_storeu_pd(s, _mm256_add_pd(_mm256_loadu_pd(s), _mm256_sub_pd(products[p], _mm256_loadu_pd(r))));
+			_mm256_storeu_pd(r, products[p]);
+		}
+	}
+	for(; i < n; i++) {
+		double x = dx[i], y = dy[i];
+		double products[3] = {x * x, x * y, y * y};
+		for(int p = 0; p < 3; p++) {
+			sums[p * n + i] += products[p] - ring[p * n + i];
+			ring[p * n + i] = products[p];
+		}
+	}
+}
+
+__attribute__((target("avx2")))
+static void eigenAVX2(const double* prefix, int stride, int n, uchar* dst) {
+	const __m256d half = _mm256_set1_pd(0.5 * eigen_scale), full = _mm256_set1_pd(eigen_scale);
+	const __m256d zero = _mm256_setzero_pd(), top = _mm256_set1_pd(255);
+	int j = 0;
+	for(; j + 4 <= n; j += 4) {
+		const double* p = prefix + j;
+		__m256d a = _mm256_mul_pd(half, _mm256_sub_pd(_mm256_loadu_pd(p + sharpness_block_size), _mm256_loadu_pd(p)));
+		p += stride;
+		__m256d b = _mm256_mul_pd(full, _mm256_sub_pd(_mm256_loadu_pd(p + sharpness_block_size), _mm256_loadu_pd(p)));
+		p += stride;
+		__m256d c = _mm256_mul_pd(half, _mm256_sub_pd(_mm256_loadu_pd(p + sharpness_block_size), _mm256_loadu_pd(p)));
+		__m256d amc = _mm256_sub_pd(a, c);
+		__m256d l = _mm256_sub_pd(_mm256_add_pd(a, c), _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(amc, amc), _mm256_mul_pd(b, b))));
+		l = _mm256_min_pd(_mm256_max_pd(l, zero), top);
+		__m128i v = _mm256_cvtpd_epi32(l);
+		v = _mm_packus_epi16(_mm_packs_epi32(v, v), v);
+		int quad = _mm_cvtsi128_si32(v);
+		memcpy(dst + j, &quad, 4);
+	}
+	eigenScalar(prefix + j, stride, n - j, dst + j);
+}
+
+#endif
+
+/**
+ * Pick the widest instruction set the processor supports, or the portable passes
+ * if useSimd is false
+ */
+SharpnessKernel::SharpnessKernel(bool useSimd) : rows(sharpness_aperture_size) {
+	vertical = verticalScalar;
+	horizontal = horizontalScalar;
+	covariance = covarianceScalar;
+	eigen = eigenScalar;
+	instructionSet = "scalar";
+	covX0 = 0;
+	covCols = 0;
+#ifdef SHARPNESS_X86
+	if(useSimd && __builtin_cpu_supports("avx2")) {
+		vertical = verticalAVX2;
+		horizontal = horizontalAVX2;
+		covariance = covarianceAVX2;
+		eigen = eigenAVX2;
+		instructionSet = "avx2";
+	} else if(useSimd && __builtin_cpu_supports("sse4.1")) {
+		vertical = verticalSSE41;
+		horizontal = horizontalSSE41;
+		covariance = covarianceSSE41;
+		eigen = eigenSSE41;
+		instructionSet = "sse4.1";
+	}
+#endif
+}
+
+const char* SharpnessKernel::getInstructionSet() {
+	return instructionSet;
+}
+
+/**
+ * Write the touch image of the pixels of source inside tile into dst, an 8 bit image
+ * of the size of tile. Pixels outside source are reflected like BORDER_REFLECT_101.
+ */
+void SharpnessKernel::compute(const Mat& source, Rect tile, Mat& dst) {
+	CV_Assert(source.type() == CV_8UC1 && dst.type() == CV_8UC1 && dst.size() == tile.size());
+	if(source.cols <= sharpness_block_size || source.rows <= sharpness_block_size) {
+		//too small to reflect the border once, leave it to OpenCV
+		Mat eigenImage;
+		cornerMinEigenVal(source, eigenImage, sharpness_block_size, sharpness_aperture_size);
+		eigenImage(tile).convertTo(dst, CV_8UC1, sharpness_scale, 0);
+		return;
+	}
+	computeRows(source.data, source.step, source.cols, source.rows, tile, dst.data, dst.step);
+}
+
+/**
+ * Stream over the rows of tile keeping only the covariance rows the box filter still needs
+ */
+void SharpnessKernel::computeRows(const uchar* source, size_t step, int width, int height, Rect tile, uchar* dst, size_t dstStep) {
+	//covariance columns read by the box filter of the tile, reflected at the image border
+	int boxCols = tile.width + sharpness_block_size - 1;
+	columnMap.resize(boxCols);
+	int x0 = width, x1 = -1;
+	for(int k = 0; k < boxCols; k++) {
+		columnMap[k] = reflect101(tile.x - box_before + k, width);
+		x0 = std::min(x0, columnMap[k]);
+		x1 = std::max(x1, columnMap[k]);
+	}
+	for(int k = 0; k < boxCols; k++) {
+		columnMap[k] -= x0;
+	}
+	covX0 = x0;
+	covCols = x1 - x0 + 1;
+
+	smooth.resize(covCols + 2 * aperture_radius);
+	deriv.resize(covCols + 2 * aperture_radius);
+	dx.resize(covCols);
+	dy.resize(covCols);
+	ring.assign(sharpness_block_size * 3 * covCols, 0);
+	sums.assign(3 * covCols, 0);
+	int stride = boxCols + 1;
+	prefix.resize(3 * stride);
+
+	//fill the window of the first output row, then slide it down one row at a time
+	for(int k = 0; k < sharpness_block_size; k++) {
+		covarianceRow(source, step, width, height, tile.y - box_before + k, &ring[k * 3 * covCols]);
+	}
+	for(int y = 0; y < tile.height; y++) {
+		if(y > 0) {
+			int row = tile.y + y + box_after;
+			int slot = (row - (tile.y - box_before)) % sharpness_block_size;
+			covarianceRow(source, step, width, height, row, &ring[slot * 3 * covCols]);
+		}
+		for(int p = 0; p < 3; p++) {
+			const double* s = &sums[p * covCols];
+			double* out = &prefix[p * stride];
+			out[0] = 0;
+			for(int k = 0; k < boxCols; k++) {
+				out[k + 1] = out[k] + s[columnMap[k]];
+			}
+		}
+		eigen(&prefix[0], stride, tile.width, dst + y * dstStep);
+	}
+}
+
+/**
+ * Derivatives of image row reflect101(row) over the covariance columns, folded into
+ * the ring slot and the column sums
+ */
+void SharpnessKernel::covarianceRow(const uchar* source, size_t step, int width, int height, int row, double* slot) {
+	int r = reflect101(row, height);
+	//source columns needed by the horizontal filters, the rest is reflected below
+	int first = covX0 - aperture_radius;
+	int c0 = std::max(first, 0);
+	int c1 = std::min(covX0 + covCols - 1 + aperture_radius, width - 1);
+	for(int t = 0; t < sharpness_aperture_size; t++) {
+		rows[t] = source + reflect101(r - aperture_radius + t, height) * step + c0;
+	}
+	vertical(&rows[0], c1 - c0 + 1, &smooth[c0 - first], &deriv[c0 - first]);
+	for(int k = 0; k < c0 - first; k++) {
+		smooth[k] = smooth[reflect101(first + k, width) - first];
+		deriv[k] = deriv[reflect101(first + k, width) - first];
+	}
+	for(int k = c1 - first + 1; k < (int)smooth.size(); k++) {
+		smooth[k] = smooth[reflect101(first + k, width) - first];
+		deriv[k] = deriv[reflect101(first + k, width) - first];
+	}
+	horizontal(&smooth[0], &deriv[0], covCols, &dx[0], &dy[0]);
+	covariance(&dx[0], &dy[0], covCols, slot, &sums[0]);
+}
+
+/**
+ * Compare the portable and the vectorized kernel with cornerMinEigenVal on a synthetic
+ * frame, for the whole frame and for a tile, then time them if timed is set. Returns
+ * false if any pixel differs from OpenCV by more than one gray level.
+ */
+bool SharpnessKernel::selfTest(std::ostream& out, bool timed) {
+	Mat frame(374, 665, CV_8UC1);
+	RNG rng(12345);
+	rng.fill(frame, RNG::UNIFORM, Scalar(0), Scalar(256));
+	GaussianBlur(frame, frame, Size(0, 0), 3);
+	for(int i = 0; i < 20; i++) {
+		circle(frame, Point(rng.uniform(0, frame.cols), rng.uniform(0, frame.rows)), rng.uniform(5, 60), Scalar(rng.uniform(0, 256)), CV_FILLED);
+	}
+	Mat eigenImage, reference;
+	cornerMinEigenVal(frame, eigenImage, sharpness_block_size, sharpness_aperture_size);
+	eigenImage.convertTo(reference, CV_8UC1, sharpness_scale, 0);
+
+	bool passed = true;
+	Rect tiles[2] = {Rect(0, 0, frame.cols, frame.rows), Rect(101, 47, 203, 117)};
+	for(int simd = 0; simd < 2; simd++) {
+		SharpnessKernel kernel(simd == 1);
+		for(int i = 0; i < 2; i++) {
+			Mat result(tiles[i].size(), CV_8UC1);
+			kernel.compute(frame, tiles[i], result);
+			Mat difference;
+			absdiff(result, reference(tiles[i]), difference);
+			double maxDifference = 0;
+			minMaxLoc(difference, NULL, &maxDifference);
+			out << "Sharpness kernel " << kernel.getInstructionSet() << " tile " << i << ": max difference from OpenCV = " << maxDifference << std::endl;
+			passed = passed && maxDifference <= 1;
+		}
+	}
+
+	if(!timed) {
+		out << "Sharpness kernel self test " << (passed ? "passed" : "FAILED") << std::endl;
+		return passed;
+	}
+
+	//microbenchmark on the whole frame
+	const int iterations = 20;
+	Mat result(frame.size(), CV_8UC1);
+	double start = (double)getTickCount();
+	for(int i = 0; i < iterations; i++) {
+		cornerMinEigenVal(frame, eigenImage, sharpness_block_size, sharpness_aperture_size);
+		eigenImage.convertTo(result, CV_8UC1, sharpness_scale, 0);
+	}
+	double opencvTime = ((double)getTickCount() - start) / getTickFrequency() / iterations;
+	out << std::fixed << std::setprecision(3) << "Sharpness opencv: " << opencvTime * 1000 << " ms/frame" << std::endl;
+	for(int simd = 0; simd < 2; simd++) {
+		SharpnessKernel kernel(simd == 1);
+		start = (double)getTickCount();
+		for(int i = 0; i < iterations; i++) {
+			kernel.compute(frame, Rect(0, 0, frame.cols, frame.rows), result);
+		}
+		double kernelTime = ((double)getTickCount() - start) / getTickFrequency() / iterations;
+		out << "Sharpness fused " << kernel.getInstructionSet() << ": " << kernelTime * 1000 << " ms/frame, "
+			<< opencvTime / kernelTime << "x" << std::endl;
+	}
+	out << "Sharpness kernel self test " << (passed ? "passed" : "FAILED") << std::endl;
+	return passed;
+}
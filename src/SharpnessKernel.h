@@ -0,0 +1,81 @@
+/*
+ * SharpnessKernel.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHARPNESSKERNEL_H_
+#define SHARPNESSKERNEL_H_
+
+#include "cv.h"
+#include <vector>
+#include <ostream>
+
+//cornerMinEigenVal parameters of the touch image, see sharpnessImage()
+const int sharpness_block_size = 16;
+const int sharpness_aperture_size = 9;
+//distance over which a pixel of the source influences the touch image
+const int sharpness_kernel_radius = sharpness_block_size / 2 + sharpness_aperture_size / 2;
+//scale from the minimum eigenvalue to the 8 bit touch image
+const double sharpness_scale = 50;
+
+/**
+ * Touch image kernel that fuses the Sobel derivatives, the box filter of their products,
+ * the minimum eigenvalue and the conversion to 8 bit into one pass over the rows of a tile.
+ * The result equals cornerMinEigenVal(source, eig, 16, 9) followed by
+ * eig.convertTo(dst, CV_8UC1, 50) to within one gray level, without any float image.
+ * Derivatives are exact integers and the covariance sums are kept exactly in doubles,
+ * using AVX2 or SSE4.1 when the processor has them.
+ */
+class SharpnessKernel {
+
+public:
+	SharpnessKernel(bool useSimd = true);
+	void compute(const cv::Mat& source, cv::Rect tile, cv::Mat& dst);
+	const char* getInstructionSet();
+	static bool selfTest(std::ostream& out, bool timed);
+
+private:
+	typedef void (*VerticalPass)(const uchar* const* rows, int n, float* smooth, float* deriv);
+	typedef void (*HorizontalPass)(const float* smooth, const float* deriv, int n, float* dx, float* dy);
+	typedef void (*CovariancePass)(const float* dx, const float* dy, int n, double* ring, double* sums);
+	typedef void (*EigenPass)(const double* prefix, int stride, int n, uchar* dst);
+
+	void computeRows(const uchar* source, size_t step, int width, int height, cv::Rect tile, uchar* dst, size_t dstStep);
+	void covarianceRow(const uchar* source, size_t step, int width, int height, int row, double* ring);
+
+	VerticalPass vertical;
+	HorizontalPass horizontal;
+	CovariancePass covariance;
+	EigenPass eigen;
+	const char* instructionSet;
+
+	int covX0; //first image column of the covariance rows of the current tile
+	int covCols; //number of columns of the covariance rows
+	std::vector<const uchar*> rows; //the nine source rows of the derivative filters
+	std::vector<float> smooth; //vertically smoothed source row, with reflected border
+	std::vector<float> deriv; //vertically differentiated source row, with reflected border
+	std::vector<float> dx;
+	std::vector<float> dy;
+	std::vector<double> ring; //dx*dx, dx*dy, dy*dy of the last block size rows
+	std::vector<double> sums; //column sums of ring
+	std::vector<double> prefix; //prefix sums along the output row of the column sums
+	std::vector<int> columnMap; //covariance column read by each position of the box filter
+};
+
+#endif /* SHARPNESSKERNEL_H_ */
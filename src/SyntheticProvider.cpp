@@ -0,0 +1,188 @@
+/*
+ * SyntheticProvider.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SyntheticProvider.h"
+
+#include <cmath>
+#include <boost/thread.hpp>
+
+using namespace cv;
+
+//length of one grab/release cycle of the synthetic hands in frames
+const int gesture_cycle_frames = 240;
+//frame rate the timestamps assume when the scene is rendered as fast as it is tracked
+const float synthetic_nominal_fps = 30;
+
+SyntheticProvider::SyntheticProvider() {
+	seed = 0;
+	blurSigma = 0;
+	noiseSigma = 0;
+	frameInterval = 0;
+	nextFrameTime = 0;
+	firstFrameTime = 0;
+	frameNumber = 0;
+}
+
+SyntheticProvider::~SyntheticProvider() {
+	stopCapture();
+}
+
+/**
+ * Set up the scene. All the random parameters of the hand motion are derived from seed.
+ * framesPerSecond of 0 delivers frames as fast as they are consumed.
+ * */
+void SyntheticProvider::init(unsigned int seed, int numHands, Size size, float blurSigma, float noiseSigma, float framesPerSecond) {
+	this->seed = seed;
+	this->size = size;
+	this->blurSigma = blurSigma;
+	this->noiseSigma = noiseSigma;
+	frameInterval = framesPerSecond > 0 ? 1.0f / framesPerSecond : 0;
+	fps = framesPerSecond;
+	nextFrameTime = 0;
+	firstFrameTime = 0;
+	frameNumber = 0;
+
+	canvas.create(size, CV_8UC1);
+	noise.create(size, CV_16SC1);
+	noisyCanvas.create(size, CV_16SC1);
+	image.create(size, CV_8UC1);
+
+	RNG rng(seed);
+	hands.clear();
+	for(int i = 0; i < std::min(std::max(numHands, 1), 2); i++) {
+		HandPath path;
+		//first hand on the left half of the image, second on the right half
+		path.center = Point2f(size.width * (numHands == 1 ? 0.5f : 0.3f + 0.4f * i), size.height * 0.55f);
+		path.amplitude = Point2f(size.width * rng.uniform(0.04f, 0.1f), size.height * rng.uniform(0.04f, 0.1f));
+		path.speed = rng.uniform(0.01f, 0.03f);
+		path.phase = rng.uniform(0.f, (float)CV_PI * 2);
+		path.angle = (float)(-CV_PI / 2) + rng.uniform(-0.3f, 0.3f);
+		path.gesturePhase = rng.uniform(0, gesture_cycle_frames);
+		hands.push_back(path);
+	}
+}
+
+/**
+ * How far the fingers of a hand are extended on the grab/release script, from 0 for a
+ * closed fist to 1 for an open hand: open, grab, hold closed, release, repeat.
+ * */
+float SyntheticProvider::grabOpenness(int frameNumber) {
+	int t = frameNumber % gesture_cycle_frames;
+	const int open_frames = 100, grab_frames = 20, closed_frames = 100;
+	if(t < open_frames) {
+		return 1;
+	}
+	t -= open_frames;
+	if(t < grab_frames) {
+		return 1 - t / (float)grab_frames;
+	}
+	t -= grab_frames;
+	if(t < closed_frames) {
+		return 0;
+	}
+	t -= closed_frames;
+	return t / (float)(gesture_cycle_frames - open_frames - grab_frames - closed_frames);
+}
+
+/**
+ * Draw one hand as a bright palm with five fingers. Finger tips are the brightest part,
+ * as they are the closest to the diffuser.
+ * */
+void SyntheticProvider::renderHand(const HandPath& path, int frameNumber) {
+	float scale = size.height / 480.0f;
+	Point2f palm = path.center + Point2f(path.amplitude.x * std::sin(path.speed * frameNumber + path.phase),
+			path.amplitude.y * std::sin(path.speed * frameNumber * 1.3f + path.phase));
+	float openness = grabOpenness(frameNumber + path.gesturePhase);
+	int palmRadius = cvRound(45 * scale);
+
+	ellipse(canvas, palm, Size(palmRadius, cvRound(palmRadius * 1.15f)), path.angle * 180 / CV_PI + 90, 0, 360, Scalar(150), CV_FILLED, 8);
+	for(int finger = 0; finger < 5; finger++) {
+		//fingers fan out when the hand is open and bunch together when it closes
+		float spread = (finger - 2) * (0.22f + 0.18f * openness);
+		float direction = path.angle + spread;
+		float length = palmRadius * (0.5f + 1.3f * openness) * (finger == 0 || finger == 4 ? 0.8f : 1.0f);
+		Point2f base = palm + Point2f(std::cos(direction), std::sin(direction)) * (palmRadius * 0.7f);
+		Point2f tip = base + Point2f(std::cos(direction), std::sin(direction)) * length;
+		int thickness = std::max(2, cvRound(13 * scale));
+		line(canvas, base, tip, Scalar(170), thickness, 8);
+		circle(canvas, tip, thickness / 2 + 1, Scalar(230), CV_FILLED, 8);
+	}
+}
+
+/**
+ * Render the next frame. The result is only valid until the next call.
+ * */
+Mat SyntheticProvider::grabImage() {
+	canvas.setTo(Scalar(8));
+	for(unsigned int i = 0; i < hands.size(); i++) {
+		renderHand(hands[i], frameNumber);
+	}
+	if(blurSigma > 0) {
+		GaussianBlur(canvas, canvas, Size(0, 0), blurSigma);
+	}
+	if(noiseSigma > 0) {
+		//noise of every frame comes from its own generator so frames do not depend on each other
+		RNG rng((unsigned long long)seed * 2654435761u + frameNumber);
+		rng.fill(noise, RNG::NORMAL, Scalar(0), Scalar(noiseSigma));
+		canvas.convertTo(noisyCanvas, CV_16SC1);
+		noisyCanvas += noise;
+		noisyCanvas.convertTo(image, CV_8UC1);
+	} else {
+		canvas.copyTo(image);
+	}
+	frameNumber++;
+
+	if(frameInterval > 0) {
+		double now = captureTime();
+		if(nextFrameTime == 0) {
+			nextFrameTime = now;
+		} else if(now < nextFrameTime) {
+			boost::this_thread::sleep(boost::posix_time::microseconds((long)((nextFrameTime - now) * 1e6)));
+		}
+		nextFrameTime += frameInterval;
+	}
+	return image;
+}
+
+/**
+ * Stamp each frame with its time in the scene instead of the time it was rendered, so
+ * velocities and filtering do not depend on how fast the tracker runs.
+ * */
+bool SyntheticProvider::grabFrame(Frame& frame) {
+	if(!ImageProvider::grabFrame(frame)) {
+		return false;
+	}
+	//grabImage() has already moved on to the next frame
+	int number = frameNumber - 1;
+	if(number == 0) {
+		firstFrameTime = frame.timestamp;
+	}
+	float interval = frameInterval > 0 ? frameInterval : 1.0f / synthetic_nominal_fps;
+	frame.timestamp = firstFrameTime + number * interval;
+	return true;
+}
+
+/**
+ * Like a recording, the synthetic scene can wait for the tracker so no frame is dropped
+ * */
+bool SyntheticProvider::isLive() {
+	return false;
+}
@@ -0,0 +1,75 @@
+/*
+ * SyntheticProvider.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SYNTHETICPROVIDER_H_
+#define SYNTHETICPROVIDER_H_
+
+#include "cv.h"
+
+#include "ImageProvider.h"
+
+/**
+ * Procedurally rendered infrared scene with one or two bright hands whose fingers
+ * open and close on a fixed grab/release script. Every frame is a pure function of
+ * the seed and the frame number, so runs are bit-identical and can be used as a
+ * benchmark fixture on machines without a camera.
+ */
+class SyntheticProvider : public ImageProvider {
+
+public:
+	SyntheticProvider();
+	void init(unsigned int seed, int numHands, cv::Size size, float blurSigma, float noiseSigma, float framesPerSecond);
+	cv::Mat grabImage();
+	~SyntheticProvider();
+
+protected:
+	bool grabFrame(Frame& frame);
+	bool isLive();
+
+private:
+	struct HandPath {
+		cv::Point2f center; //centre of the motion in the image
+		cv::Point2f amplitude; //how far the hand wanders from the centre
+		float speed; //radians per frame of the wandering motion
+		float phase;
+		float angle; //direction the fingers point to, in radians
+		int gesturePhase; //frame offset into the grab/release script
+	};
+
+	void renderHand(const HandPath& path, int frameNumber);
+	float grabOpenness(int frameNumber);
+
+	std::vector<HandPath> hands;
+	unsigned int seed;
+	cv::Size size;
+	float blurSigma; //sigma of the gaussian blur, 0 for a perfectly sharp image
+	float noiseSigma; //sigma of the sensor noise in gray levels, 0 for no noise
+	float frameInterval; //seconds between frames, 0 to render as fast as possible
+	double nextFrameTime;
+	double firstFrameTime; //capture time of frame 0, the others are stamped relative to it
+	int frameNumber;
+	cv::Mat canvas; //rendered scene before noise
+	cv::Mat noise; //signed noise added to the scene
+	cv::Mat noisyCanvas; //scene plus noise before saturation to 8 bit
+	cv::Mat image; //final 8 bit frame
+};
+
+#endif /* SYNTHETICPROVIDER_H_ */
@@ -106,19 +106,126 @@ Undistortion::Undistortion() {
     //newCameraMatrix = getOptimalNewCameraMatrix(intrinsic, distortion, Size(setting->pgr_cam_max_width,setting->pgr_cam_max_height), setting->undistortion_factor);
     newCameraMatrix = getOptimalNewCameraMatrix(intrinsic, distortion, Size(setting->pgr_cam_max_width, setting->pgr_cam_max_height), setting->undistortion_factor, Size(setting->pgr_cam_max_width, setting->pgr_cam_max_height), &validRect, true);
 	//newCameraMatrix = getDefaultNewCameraMatrix(intrinsic, Size(setting->pgr_cam_max_width,setting->pgr_cam_max_height), true);
+	//compute the undistortion maps once instead of letting undistort() rebuild them every frame
+	initUndistortRectifyMap(intrinsic, distortion, Mat(), newCameraMatrix, Size(setting->pgr_cam_max_width, setting->pgr_cam_max_height), CV_32FC1, mapx, mapy);
 }
 
 /**
  * Process the image to remove lens distortion by remapping the image
- * based on stored calibration data
+ * based on stored calibration data. src and dst must not be the same image,
+ * dst is not reallocated if it already has the right size and type.
  * */
-void Undistortion::undistortImage(Mat* image){
-	//TODO: check to see if cloning here is necessary
-	Mat distorted = image->clone();
-	//cvRemap(image, undistImage, mapx, mapy);
-	undistort(distorted, *image, intrinsic, distortion, newCameraMatrix);
-    distorted.release();
-	//cvUndistort2(image, undistImage, intrinsic, distortion, newCameraMatrix);
+void Undistortion::undistortImage(const Mat& src, Mat& dst){
+	//same result as undistort() but with the maps computed in the constructor
+	remap(src, dst, mapx, mapy, INTER_LINEAR, BORDER_CONSTANT);
+}
+
+/**
+ * Undistort, flip horizontally and crop to the ROI in one remap of the sensor image.
+ * The result is the same as centring the sensor image in a pgr_cam_max_width x
+ * pgr_cam_max_height container, undistorting, flipping and then cropping.
+ * The table is rebuilt whenever the sensor size or the ROI in the settings change.
+ * */
+void Undistortion::remapToROI(const Mat& sensorImage, Mat& dst) {
+	Rect roiRect = currentROI();
+	if(roiRect != roiMapRect || sensorImage.size() != roiMapSensorSize) {
+		buildROIMap(roiRect, true, sensorImage.size(), roiMap1, roiMap2);
+		roiMapRect = roiRect;
+		roiMapSensorSize = sensorImage.size();
+		verbosePrint("Undistortion remap table built for the current ROI");
+	}
+	remap(sensorImage, dst, roiMap1, roiMap2, INTER_LINEAR, BORDER_CONSTANT);
+}
+
+/**
+ * Undistort an image that has already been flipped and cropped to the ROI without
+ * undistortion. Used to display frames when only feature points are undistorted.
+ * */
+void Undistortion::undistortROIImage(const Mat& roiImage, Mat& dst) {
+	Rect roiRect = currentROI();
+	if(roiRect != displayMapRect) {
+		buildROIMap(roiRect, false, Size(), displayMap1, displayMap2);
+		displayMapRect = roiRect;
+	}
+	remap(roiImage, dst, displayMap1, displayMap2, INTER_LINEAR, BORDER_CONSTANT);
+}
+
+/**
+ * Move points found in the distorted (flipped and cropped) ROI image to where they
+ * would have been found in the undistorted ROI image
+ * */
+void Undistortion::undistortROIPoints(vector<Point2f>& points) {
+	if(points.empty()) {
+		return;
+	}
+	Rect roiRect = currentROI();
+	float lastColumn = setting->pgr_cam_max_width - 1;
+	//back to the unflipped full size image that the calibration belongs to
+	for(unsigned int i = 0; i < points.size(); i++) {
+		points[i].x = lastColumn - (points[i].x + roiRect.x);
+		points[i].y = points[i].y + roiRect.y;
+	}
+	undistortPoints(points, undistortedPoints, intrinsic, distortion, Mat(), newCameraMatrix);
+	for(unsigned int i = 0; i < points.size(); i++) {
+		points[i].x = lastColumn - undistortedPoints[i].x - roiRect.x;
+		points[i].y = undistortedPoints[i].y - roiRect.y;
+	}
+}
+
+/**
+ * Same as undistortROIPoints() for the integer points of a contour
+ * */
+void Undistortion::undistortROIContour(vector<Point>& contour) {
+	contourPoints.resize(contour.size());
+	for(unsigned int i = 0; i < contour.size(); i++) {
+		contourPoints[i] = contour[i];
+	}
+	undistortROIPoints(contourPoints);
+	for(unsigned int i = 0; i < contour.size(); i++) {
+		contour[i] = Point(cvRound(contourPoints[i].x), cvRound(contourPoints[i].y));
+	}
+}
+
+/**
+ * The ROI from the settings, clipped to the full size image
+ * */
+Rect Undistortion::currentROI() {
+	return Rect(setting->imageOffsetX, setting->imageOffsetY, setting->imageSizeX, setting->imageSizeY)
+			& Rect(0, 0, setting->pgr_cam_max_width, setting->pgr_cam_max_height);
+}
+
+/**
+ * Compose the undistortion maps with the flip and crop applied by the camera and
+ * store the result as a fixed point table for remap(). With fromSensor the table reads
+ * from the raw sensor image (centred in the full size container), otherwise it reads
+ * from an image that has already been flipped and cropped to roiRect.
+ * */
+void Undistortion::buildROIMap(Rect roiRect, bool fromSensor, Size sensorSize, Mat& map1, Mat& map2) {
+	int bigWidth = setting->pgr_cam_max_width;
+	//offset of the sensor image inside the container the calibration was done in
+	float padX = (bigWidth - sensorSize.width) / 2;
+	float padY = (setting->pgr_cam_max_height - sensorSize.height) / 2;
+
+	Mat roiMapX(roiRect.size(), CV_32FC1);
+	Mat roiMapY(roiRect.size(), CV_32FC1);
+	for(int y = 0; y < roiRect.height; y++) {
+		const float* mx = mapx.ptr<float>(y + roiRect.y);
+		const float* my = mapy.ptr<float>(y + roiRect.y);
+		float* rx = roiMapX.ptr<float>(y);
+		float* ry = roiMapY.ptr<float>(y);
+		for(int x = 0; x < roiRect.width; x++) {
+			//column of the undistorted image that ends up at x after the flip
+			int column = bigWidth - 1 - (x + roiRect.x);
+			if(fromSensor) {
+				rx[x] = mx[column] - padX;
+				ry[x] = my[column] - padY;
+			} else {
+				rx[x] = bigWidth - 1 - mx[column] - roiRect.x;
+				ry[x] = my[column] - roiRect.y;
+			}
+		}
+	}
+	convertMaps(roiMapX, roiMapY, map1, map2, CV_16SC2);
 }
 
 void Undistortion::saveCalibrationData(Mat intrinsic, Mat distortion, float offsetX, float offsetY, float sizeX, float sizeY) {
@@ -328,7 +435,7 @@ void Undistortion::settingsLoop(CameraPGR* cam) {
 		case 'q':
 			cvDestroyWindow("Original Image");
 			cvDestroyWindow("Undistorted/Cropped Image");
-			cam->~CameraPGR();
+			cam->close();
 			exit(0);
 
 		case 'h':
@@ -428,7 +535,7 @@ void Undistortion::calibrateUndistortion(CameraPGR* cam) {
 				cvDestroyWindow("Camera");
 				cvDestroyWindow("Detected Corners");
 				cvDestroyWindow("Captured Corners");
-				cam->~CameraPGR();
+				cam->close();
 				exit(0);
 
 			case 'h':
@@ -28,16 +28,31 @@ class Undistortion {
 
 public:
 	Undistortion();
-	void undistortImage(cv::Mat* image);
+	void undistortImage(const cv::Mat& src, cv::Mat& dst);
+	void remapToROI(const cv::Mat& sensorImage, cv::Mat& dst);
+	void undistortROIImage(const cv::Mat& roiImage, cv::Mat& dst);
+	void undistortROIPoints(std::vector<cv::Point2f>& points);
+	void undistortROIContour(std::vector<cv::Point>& contour);
 	void settingsLoop(CameraPGR* cam);
 
 private:
 	cv::Mat mapx;
 	cv::Mat mapy;
+	cv::Mat roiMap1; //fixed point (CV_16SC2) map from the sensor image straight to the flipped ROI
+	cv::Mat roiMap2; //interpolation table that goes with roiMap1
+	cv::Rect roiMapRect; //ROI that roiMap1 and roiMap2 were built for
+	cv::Size roiMapSensorSize; //sensor image size that roiMap1 and roiMap2 were built for
+	cv::Mat displayMap1; //fixed point map from the distorted ROI to the undistorted ROI
+	cv::Mat displayMap2; //interpolation table that goes with displayMap1
+	cv::Rect displayMapRect; //ROI that displayMap1 and displayMap2 were built for
+	std::vector<cv::Point2f> contourPoints; //reused by undistortROIContour()
+	std::vector<cv::Point2f> undistortedPoints; //reused by undistortROIPoints()
 	cv::Mat intrinsic;
 	cv::Mat distortion;
 	cv::Mat newCameraMatrix;
 
+	cv::Rect currentROI();
+	void buildROIMap(cv::Rect roiRect, bool fromSensor, cv::Size sensorSize, cv::Mat& map1, cv::Mat& map2);
 	void calibrateUndistortion(CameraPGR* cam);
 	void saveCalibrationData(cv::Mat intrinsic, cv::Mat distortion, float offsetX, float offsetY, float sizeX, float sizeY);
 	void printKeysSettings();
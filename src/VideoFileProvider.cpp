@@ -0,0 +1,118 @@
+/*
+ * VideoFileProvider.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "VideoFileProvider.h"
+#include "Log.h"
+
+#include <boost/thread.hpp>
+#include <boost/lexical_cast.hpp>
+
+VideoFileProvider::VideoFileProvider() {
+	asFastAsPossible = false;
+	frameInterval = 1.0 / 30;
+	nextFrameTime = 0;
+	firstFrameTime = 0;
+	framesRead = 0;
+}
+
+VideoFileProvider::~VideoFileProvider() {
+	//stop the decoding thread before the decoder goes away
+	stopCapture();
+}
+
+/**
+ * Open the video file at path. With asFastAsPossible frames are decoded as fast as the
+ * tracker consumes them, otherwise they are paced at the frame rate of the recording.
+ * Returns false if the file could not be opened.
+ * */
+bool VideoFileProvider::open(std::string path, bool asFastAsPossible) {
+	this->asFastAsPossible = asFastAsPossible;
+	if(!video.open(path)) {
+		return false;
+	}
+	fps = video.get(CV_CAP_PROP_FPS);
+	if(fps <= 0) {
+		//some containers do not store a frame rate
+		fps = 30;
+	}
+	frameInterval = 1.0 / fps;
+	nextFrameTime = 0;
+	firstFrameTime = 0;
+	framesRead = 0;
+	verbosePrint("Video fps = " + boost::lexical_cast<std::string>(fps));
+	return true;
+}
+
+/**
+ * Decode the next frame and convert it to grayscale.
+ * Returns an empty image at the end of the file.
+ * */
+cv::Mat VideoFileProvider::grabImage() {
+	if(!video.read(decodedImage) || decodedImage.empty()) {
+		return cv::Mat();
+	}
+	if(decodedImage.channels() == 3) {
+		cvtColor(decodedImage, grayImage, CV_RGB2GRAY);
+	} else {
+		grayImage = decodedImage;
+	}
+
+	if(!asFastAsPossible) {
+		double now = captureTime();
+		if(nextFrameTime == 0) {
+			nextFrameTime = now;
+		} else if(now < nextFrameTime) {
+			boost::this_thread::sleep(boost::posix_time::microseconds((long)((nextFrameTime - now) * 1e6)));
+		}
+		nextFrameTime += frameInterval;
+	}
+	return grayImage;
+}
+
+/**
+ * Frame rate of the recording
+ * */
+double VideoFileProvider::getFPS() {
+	return fps;
+}
+
+/**
+ * Stamp every frame with its time in the recording, counted from the capture time of the
+ * first frame, so motion in pixels per second does not depend on how fast it is decoded
+ * */
+bool VideoFileProvider::grabFrame(Frame& frame) {
+	if(!ImageProvider::grabFrame(frame)) {
+		return false;
+	}
+	if(framesRead == 0) {
+		firstFrameTime = frame.timestamp;
+	}
+	frame.timestamp = firstFrameTime + framesRead * frameInterval;
+	framesRead++;
+	return true;
+}
+
+/**
+ * A recording can always wait for the tracker, so no frame is ever dropped
+ * */
+bool VideoFileProvider::isLive() {
+	return false;
+}
@@ -0,0 +1,58 @@
+/*
+ * VideoFileProvider.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VIDEOFILEPROVIDER_H_
+#define VIDEOFILEPROVIDER_H_
+
+#include "cv.h"
+#include "highgui.h"
+
+#include "ImageProvider.h"
+
+/**
+ * Grayscale frames decoded from a recorded video file. When capturing, decoding
+ * runs on the capture thread and fills a bounded queue ahead of the tracker.
+ */
+class VideoFileProvider : public ImageProvider {
+
+public:
+	VideoFileProvider();
+	bool open(std::string path, bool asFastAsPossible);
+	cv::Mat grabImage();
+	double getFPS();
+	~VideoFileProvider();
+
+protected:
+	bool grabFrame(Frame& frame);
+	bool isLive();
+
+private:
+	cv::VideoCapture video;
+	cv::Mat decodedImage; //frame as it comes out of the decoder
+	cv::Mat grayImage; //grayscale version handed to the tracker
+	bool asFastAsPossible; //if false frames are delivered at the frame rate of the recording
+	double frameInterval; //seconds between frames of the recording
+	double nextFrameTime; //time at which the next frame is due in real time mode
+	double firstFrameTime; //capture time of the first frame, frames are stamped from it
+	unsigned long framesRead; //frames decoded since open()
+};
+
+#endif /* VIDEOFILEPROVIDER_H_ */
@@ -0,0 +1,135 @@
+/*
+ * WorkerPool.cpp
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+WorkerPool::WorkerPool(int threads) {
+	threadCount = 1;
+	task = NULL;
+	count = 0;
+	next = 0;
+	pending = 0;
+	batch = 0;
+	running = false;
+	start(threads);
+}
+
+WorkerPool::~WorkerPool() {
+	stop();
+}
+
+/**
+ * (Re)start the pool with the given total number of threads including the caller,
+ * 0 to use one per core
+ */
+void WorkerPool::start(int threads) {
+	stop();
+	if(threads <= 0) {
+		threads = std::max(1u, boost::thread::hardware_concurrency());
+	}
+	threadCount = threads;
+	running = true;
+	for(int i = 1; i < threadCount; i++) {
+		workers.create_thread(boost::bind(&WorkerPool::workerLoop, this, i));
+	}
+}
+
+void WorkerPool::stop() {
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		running = false;
+	}
+	batchReady.notify_all();
+	workers.join_all();
+	threadCount = 1;
+}
+
+int WorkerPool::getThreadCount() {
+	return threadCount;
+}
+
+/**
+ * Call task.run(i, worker) for every i in [0, count) spread over the pool and
+ * wait until all of them have returned
+ */
+void WorkerPool::run(WorkerTask& task, int count) {
+	if(count <= 0) {
+		return;
+	}
+	if(threadCount == 1 || count == 1) {
+		for(int i = 0; i < count; i++) {
+			task.run(i, 0);
+		}
+		return;
+	}
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		this->task = &task;
+		this->count = count;
+		next = 0;
+		pending = count;
+		batch++;
+	}
+	batchReady.notify_all();
+	work(0);
+	boost::mutex::scoped_lock lock(mutex);
+	while(pending > 0) {
+		batchDone.wait(lock);
+	}
+	this->task = NULL;
+}
+
+/**
+ * Take indexes of the current batch until there are none left
+ */
+void WorkerPool::work(int worker) {
+	boost::mutex::scoped_lock lock(mutex);
+	while(next < count) {
+		int index = next++;
+		WorkerTask* current = task;
+		lock.unlock();
+		current->run(index, worker);
+		lock.lock();
+		if(--pending == 0) {
+			batchDone.notify_all();
+		}
+	}
+}
+
+void WorkerPool::workerLoop(int worker) {
+	unsigned long seen = 0;
+	while(true) {
+		{
+			boost::mutex::scoped_lock lock(mutex);
+			while(running && batch == seen) {
+				batchReady.wait(lock);
+			}
+			if(!running) {
+				return;
+			}
+			seen = batch;
+		}
+		work(worker);
+	}
+}
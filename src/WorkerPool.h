@@ -0,0 +1,75 @@
+/*
+ * WorkerPool.h
+ *
+ *  Created on: 2026-10-18
+ *      Author: Aras Balali Moghaddam
+ *
+ *  This file is part of Gibbon (Bimanual Near Touch Tracker).
+ *
+ *  Gibbon is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation version 3.
+ *
+ *  Gibbon is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Gibbon.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+#include <vector>
+#include <boost/thread.hpp>
+
+/**
+ * A unit of parallel work. run() is called once for every index of a batch,
+ * worker identifies the thread calling it (0 is the thread that started the batch)
+ * so tasks can keep one scratch buffer per thread.
+ */
+class WorkerTask {
+
+public:
+	virtual ~WorkerTask() {}
+	virtual void run(int index, int worker) = 0;
+};
+
+/**
+ * Persistent pool of threads that run batches of indexed tasks. The thread starting
+ * a batch works on it too and run() returns when every index is done, so a pool of
+ * one thread runs everything serially on the caller.
+ */
+class WorkerPool {
+
+public:
+	WorkerPool(int threads = 1);
+	~WorkerPool();
+	void start(int threads);
+	void stop();
+	int getThreadCount();
+	void run(WorkerTask& task, int count);
+
+private:
+	void workerLoop(int worker);
+	void work(int worker);
+
+	boost::thread_group workers;
+	int threadCount; //workers plus the thread calling run()
+	boost::mutex mutex; //guards everything below
+	boost::condition_variable batchReady;
+	boost::condition_variable batchDone;
+	WorkerTask* task; //task of the current batch
+	int count; //number of indexes in the current batch
+	int next; //next index to hand out
+	int pending; //indexes not finished yet
+	unsigned long batch; //number of batches started, workers wait for it to change
+	bool running;
+
+	WorkerPool(const WorkerPool&); //Prevent copy-construction
+	WorkerPool& operator=(const WorkerPool&); //Prevent assignment
+};
+
+#endif /* WORKERPOOL_H_ */